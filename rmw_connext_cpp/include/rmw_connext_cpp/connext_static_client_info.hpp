@@ -15,10 +15,27 @@
 #ifndef RMW_CONNEXT_CPP__CONNEXT_STATIC_CLIENT_INFO_HPP_
 #define RMW_CONNEXT_CPP__CONNEXT_STATIC_CLIENT_INFO_HPP_
 
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+
+#include "rmw/error_handling.h"
+#include "rmw/types.h"
+
 #include "rmw_connext_shared_cpp/ndds_include.hpp"
+#include "rmw_connext_shared_cpp/trigger_guard_condition.hpp"
+
+#include "rmw_connext_cpp/identifier.hpp"
+#include "rmw_connext_cpp/request_time_table.hpp"
+#include "rmw_connext_cpp/time_histogram_recorder.hpp"
 
 #include "rosidl_typesupport_connext_cpp/service_type_support.h"
 
+class ConnextClientListener;
+class InFlightRequests;
+class SharedRequesterClient;
+
 extern "C"
 {
 struct ConnextStaticClientInfo
@@ -27,7 +44,123 @@ struct ConnextStaticClientInfo
   DDS::DataReader * response_datareader_;
   DDS::ReadCondition * read_condition_;
   const service_type_support_callbacks_t * callbacks_;
+  // only set for clients of serialized requests, which have no requester
+  DDS::DataWriter * request_datawriter_;
+  ConnextClientListener * listener_;
+  // matches of the request datawriter and the response datareader, kept by the listener
+  std::atomic<DDS::Long> request_subscription_count_;
+  std::atomic<DDS::Long> response_publication_count_;
+  // only set once the request window is initialized
+  InFlightRequests * in_flight_;
+  DDS::GuardCondition * expiry_condition_;
+  std::atomic<uint64_t> requests_sent_;
+  RequestTimeTable request_times_;
+  TimeHistogramRecorder round_trip_time_;
+  // only set for serialized clients sharing the entities of their node
+  SharedRequesterClient * shared_requester_;
+  DDS::GuardCondition * reply_condition_;
 };
 }  // extern "C"
 
+// In the Connext RPC implementation, a server is ready when:
+//   - At least one subscriber is matched to the request publisher.
+//   - At least one publisher is matched to the reponse subscription.
+inline bool
+is_service_server_available(const ConnextStaticClientInfo & client_info)
+{
+  return client_info.request_subscription_count_.load() > 0 &&
+         client_info.response_publication_count_.load() > 0;
+}
+
+/// Keeps the matched counts of a client and tells the graph when its server comes and goes.
+/**
+ * The listener is attached to both the request datawriter and the response datareader.
+ */
+class ConnextClientListener : public DDS::DataWriterListener, public DDS::DataReaderListener
+{
+public:
+  ConnextClientListener(
+    ConnextStaticClientInfo * client_info,
+    rmw_guard_condition_t * graph_guard_condition)
+  : client_info_(client_info),
+    graph_guard_condition_(graph_guard_condition),
+    publication_matched_(false),
+    subscription_matched_(false)
+  {}
+
+  virtual void on_publication_matched(
+    DDSDataWriter *,
+    const DDS_PublicationMatchedStatus & status)
+  {
+    // the datawriter and the datareader report their matches from different threads
+    std::lock_guard<std::mutex> lock(mutex_);
+    publication_matched_ = true;
+    update(client_info_->request_subscription_count_, status.current_count);
+  }
+
+  virtual void on_subscription_matched(
+    DDSDataReader *,
+    const DDS_SubscriptionMatchedStatus & status)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscription_matched_ = true;
+    update(client_info_->response_publication_count_, status.current_count);
+  }
+
+  /// Pick up the matches made before the listener was attached.
+  bool
+  update_matched_counts(DDS::DataWriter * request_datawriter, DDS::DataReader * response_datareader)
+  {
+    DDS::PublicationMatchedStatus publication_matched_status;
+    DDS::SubscriptionMatchedStatus subscription_matched_status;
+    if (request_datawriter->get_publication_matched_status(
+        publication_matched_status) != DDS::RETCODE_OK)
+    {
+      RMW_SET_ERROR_MSG("failed to get publication matched status");
+      return false;
+    }
+    if (response_datareader->get_subscription_matched_status(
+        subscription_matched_status) != DDS::RETCODE_OK)
+    {
+      RMW_SET_ERROR_MSG("failed to get subscription matched status");
+      return false;
+    }
+    // The statuses are read without the lock, since Connext calls the listener with the
+    // entities locked. A count the listener reported since it was attached is at least as
+    // recent as the one read here, and the later matches are all reported by the listener.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!publication_matched_) {
+      update(client_info_->request_subscription_count_, publication_matched_status.current_count);
+    }
+    if (!subscription_matched_) {
+      update(
+        client_info_->response_publication_count_, subscription_matched_status.current_count);
+    }
+    return true;
+  }
+
+private:
+  // Called with mutex_ held.
+  void
+  update(std::atomic<DDS::Long> & count, DDS::Long current_count)
+  {
+    bool was_available = is_service_server_available(*client_info_);
+    count = current_count;
+    if (was_available == is_service_server_available(*client_info_)) {
+      return;
+    }
+    rmw_ret_t ret = trigger_guard_condition(rti_connext_identifier, graph_guard_condition_);
+    if (ret != RMW_RET_OK) {
+      fprintf(stderr, "failed to trigger graph guard condition: %s\n", rmw_get_error_string().str);
+    }
+  }
+
+  ConnextStaticClientInfo * client_info_;
+  rmw_guard_condition_t * graph_guard_condition_;
+  std::mutex mutex_;
+  // whether the listener reported the matches of the datawriter and the datareader
+  bool publication_matched_;
+  bool subscription_matched_;
+};
+
 #endif  // RMW_CONNEXT_CPP__CONNEXT_STATIC_CLIENT_INFO_HPP_
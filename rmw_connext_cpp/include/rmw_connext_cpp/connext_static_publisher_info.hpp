@@ -16,12 +16,17 @@
 #define RMW_CONNEXT_CPP__CONNEXT_STATIC_PUBLISHER_INFO_HPP_
 
 #include <atomic>
+#include <cstdint>
 
 #include "rmw_connext_shared_cpp/types.hpp"
 
+#include "rmw_connext_cpp/time_histogram_recorder.hpp"
+
 #include "rosidl_typesupport_connext_cpp/message_type_support.h"
 
 class ConnextPublisherListener;
+class IntraProcessPublisher;
+class PublisherLoanPool;
 
 extern "C"
 {
@@ -32,6 +37,13 @@ struct ConnextStaticPublisherInfo
   DDS::DataWriter * topic_writer_;
   const message_type_support_callbacks_t * callbacks_;
   rmw_gid_t publisher_gid;
+  // true if the samples are published with an instance key
+  bool keyed_;
+  // only set if the topic is delivered in process
+  IntraProcessPublisher * intra_process_;
+  // only set once loaned messages are initialized
+  PublisherLoanPool * loan_pool_;
+  TimeHistogramRecorder serialize_time_;
 };
 }  // extern "C"
 
@@ -43,6 +55,7 @@ public:
     const DDS_PublicationMatchedStatus & status)
   {
     current_count_ = status.current_count;
+    ++match_changes_;
   }
 
   std::size_t current_count() const
@@ -50,8 +63,14 @@ public:
     return current_count_;
   }
 
+  uint64_t match_changes() const
+  {
+    return match_changes_;
+  }
+
 private:
   std::atomic<std::size_t> current_count_;
+  std::atomic<uint64_t> match_changes_;
 };
 
 #endif  // RMW_CONNEXT_CPP__CONNEXT_STATIC_PUBLISHER_INFO_HPP_
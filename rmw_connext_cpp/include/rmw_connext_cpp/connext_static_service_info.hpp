@@ -15,8 +15,16 @@
 #ifndef RMW_CONNEXT_CPP__CONNEXT_STATIC_SERVICE_INFO_HPP_
 #define RMW_CONNEXT_CPP__CONNEXT_STATIC_SERVICE_INFO_HPP_
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include "rmw_connext_shared_cpp/ndds_include.hpp"
 
+#include "rmw_connext_cpp/request_time_table.hpp"
+#include "rmw_connext_cpp/time_histogram_recorder.hpp"
+
 #include "rosidl_typesupport_connext_cpp/service_type_support.h"
 
 extern "C"
@@ -27,6 +35,18 @@ struct ConnextStaticServiceInfo
   DDS::DataReader * request_datareader_;
   DDS::ReadCondition * read_condition_;
   const service_type_support_callbacks_t * callbacks_;
+  // only set for services of serialized requests, which have no replier
+  DDS::DataWriter * response_datawriter_;
+  // only set once request lanes are initialized, in priority order without the default lane
+  // of request_datareader_, which comes after the first default_lane_ of them
+  std::vector<DDS::DataReader *> lane_datareaders_;
+  std::vector<DDS::ReadCondition *> lane_conditions_;
+  size_t default_lane_;
+  std::atomic<uint64_t> requests_taken_;
+  // responses not sent within the response timeout
+  std::atomic<uint64_t> responses_dropped_;
+  RequestTimeTable request_times_;
+  TimeHistogramRecorder response_time_;
 };
 }  // extern "C"
 
@@ -16,12 +16,17 @@
 #define RMW_CONNEXT_CPP__CONNEXT_STATIC_SUBSCRIBER_INFO_HPP_
 
 #include <atomic>
+#include <cstdint>
 
 #include "rmw_connext_shared_cpp/ndds_include.hpp"
 
+#include "rmw_connext_cpp/time_histogram_recorder.hpp"
+
 #include "rosidl_typesupport_connext_cpp/message_type_support.h"
 
 class ConnextSubscriberListener;
+class IntraProcessSubscription;
+class SubscriptionLoanPool;
 
 extern "C"
 {
@@ -30,9 +35,18 @@ struct ConnextStaticSubscriberInfo
   DDS::Subscriber * dds_subscriber_;
   ConnextSubscriberListener * listener_;
   DDS::DataReader * topic_reader_;
+  // only set for content filtered subscriptions
+  DDS::ContentFilteredTopic * content_filtered_topic_;
   DDS::ReadCondition * read_condition_;
+  // true if samples of the own participant still have to be dropped when taken
   bool ignore_local_publications;
   const message_type_support_callbacks_t * callbacks_;
+  // only set if the topic is delivered in process
+  IntraProcessSubscription * intra_process_;
+  DDS::GuardCondition * intra_process_condition_;
+  // only set once loaned messages are initialized
+  SubscriptionLoanPool * loan_pool_;
+  TimeHistogramRecorder deserialize_time_;
 };
 }  // extern "C"
 
@@ -46,13 +60,39 @@ public:
     current_count_ = status.current_count;
   }
 
+  virtual void on_sample_lost(
+    DDSDataReader *,
+    const DDS_SampleLostStatus & status)
+  {
+    lost_count_ = static_cast<uint64_t>(status.total_count);
+  }
+
+  virtual void on_sample_rejected(
+    DDSDataReader *,
+    const DDS_SampleRejectedStatus & status)
+  {
+    rejected_count_ = static_cast<uint64_t>(status.total_count);
+  }
+
   std::size_t current_count() const
   {
     return current_count_;
   }
 
+  uint64_t lost_count() const
+  {
+    return lost_count_;
+  }
+
+  uint64_t rejected_count() const
+  {
+    return rejected_count_;
+  }
+
 private:
   std::atomic<std::size_t> current_count_;
+  std::atomic<uint64_t> lost_count_;
+  std::atomic<uint64_t> rejected_count_;
 };
 
 #endif  // RMW_CONNEXT_CPP__CONNEXT_STATIC_SUBSCRIBER_INFO_HPP_
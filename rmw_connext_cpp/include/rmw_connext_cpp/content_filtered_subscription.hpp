@@ -0,0 +1,54 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_CPP__CONTENT_FILTERED_SUBSCRIPTION_HPP_
+#define RMW_CONNEXT_CPP__CONTENT_FILTERED_SUBSCRIPTION_HPP_
+
+#include "rcutils/types/string_array.h"
+
+#include "rmw/rmw.h"
+#include "rmw_connext_cpp/visibility_control.h"
+
+namespace rmw_connext_cpp
+{
+
+/// Create a subscription which only receives the messages matching a filter.
+/**
+ * Works like `rmw_create_subscription()`, but the datareader is created for a Connext
+ * ContentFilteredTopic.
+ * The filter is written in the Connext SQL syntax, e.g. `"x_ > %0 AND x_ < %1"`, and refers
+ * to the fields of the DDS type of the message, whose names end with an underscore.
+ * Writers which support it evaluate the filter before sending, so messages which do not
+ * match are neither sent to nor deserialized by this subscription.
+ * Messages of the topic are not delivered in process to a filtered subscription.
+ *
+ * \param[in] filter_expression the SQL filter expression
+ * \param[in] filter_parameters values of the `%n` placeholders of the expression, can be
+ *   `NULL` if there are none
+ * \return rmw subscription handle or `NULL` if there was an error
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_subscription_t *
+create_content_filtered_subscription(
+  const rmw_node_t * node,
+  const rosidl_message_type_support_t * type_supports,
+  const char * topic_name,
+  const rmw_qos_profile_t * qos_profile,
+  bool ignore_local_publications,
+  const char * filter_expression,
+  const rcutils_string_array_t * filter_parameters);
+
+}  // namespace rmw_connext_cpp
+
+#endif  // RMW_CONNEXT_CPP__CONTENT_FILTERED_SUBSCRIPTION_HPP_
@@ -0,0 +1,64 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_CPP__EXTENDED_MESSAGE_INFO_HPP_
+#define RMW_CONNEXT_CPP__EXTENDED_MESSAGE_INFO_HPP_
+
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rmw_connext_cpp/visibility_control.h"
+#include "rmw_connext_shared_cpp/message_info.hpp"
+
+namespace rmw_connext_cpp
+{
+
+/// Take a message together with its timestamps and sequence numbers.
+/**
+ * Works like `rmw_take_with_info()`, the message info is only filled if a message is taken.
+ * The timestamps and sequence numbers of messages received through Connext are those of
+ * their DDS sample info.
+ * Messages delivered in process carry the time they were published and delivered, and a
+ * sequence number counted by the publisher for the messages delivered in process.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if the message info is `NULL`, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+take_with_extended_info(
+  const rmw_subscription_t * subscription,
+  void * ros_message,
+  bool * taken,
+  ConnextMessageInfo * message_info);
+
+/// Take a serialized message together with its timestamps and sequence numbers.
+/**
+ * Works like `take_with_extended_info()` for `rmw_take_serialized_message_with_info()`.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if the message info is `NULL`, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+take_serialized_message_with_extended_info(
+  const rmw_subscription_t * subscription,
+  rmw_serialized_message_t * serialized_message,
+  bool * taken,
+  ConnextMessageInfo * message_info);
+
+}  // namespace rmw_connext_cpp
+
+#endif  // RMW_CONNEXT_CPP__EXTENDED_MESSAGE_INFO_HPP_
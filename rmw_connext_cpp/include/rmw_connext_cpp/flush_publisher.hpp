@@ -0,0 +1,41 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_CPP__FLUSH_PUBLISHER_HPP_
+#define RMW_CONNEXT_CPP__FLUSH_PUBLISHER_HPP_
+
+#include "rmw/rmw.h"
+#include "rmw_connext_cpp/visibility_control.h"
+
+namespace rmw_connext_cpp
+{
+
+/// Send the samples which are batched by the publisher right away.
+/**
+ * Batching is enabled per topic with the RMW_CONNEXT_BATCH_TOPICS environment variable.
+ * For publishers without batching this is a no-op.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if the publisher handle is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+flush_publisher(const rmw_publisher_t * publisher);
+
+}  // namespace rmw_connext_cpp
+
+#endif  // RMW_CONNEXT_CPP__FLUSH_PUBLISHER_HPP_
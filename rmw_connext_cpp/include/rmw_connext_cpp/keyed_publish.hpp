@@ -0,0 +1,73 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_CPP__KEYED_PUBLISH_HPP_
+#define RMW_CONNEXT_CPP__KEYED_PUBLISH_HPP_
+
+#include <cstddef>
+
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rmw_connext_cpp/visibility_control.h"
+
+namespace rmw_connext_cpp
+{
+
+/// Publish a message as a sample of the instance identified by a key.
+/**
+ * Works like `rmw_publish()` for publishers of topics listed in the
+ * `RMW_CONNEXT_KEYED_TOPICS` environment variable.
+ * Each key, e.g. the id of a robot, is a separate instance of the topic, so that the history
+ * depth, the ownership and the liveliness of the QoS apply per key.
+ * The key bytes are used as the key hash of the instance, zero padded to 16 bytes.
+ * Messages of keyed topics are not delivered in process.
+ *
+ * \param[in] key bytes identifying the instance, at most 16
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if the publisher handle or the key is `NULL` or the key
+ *   length is not between 1 and 16, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if the topic is not keyed or an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+publish_with_key(
+  const rmw_publisher_t * publisher,
+  const void * ros_message,
+  const void * key,
+  size_t key_length);
+
+/// Publish a serialized message as a sample of the instance identified by a key.
+/**
+ * Works like `publish_with_key()` for a message serialized by the application.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if the publisher handle or the key is `NULL` or the key
+ *   length is not between 1 and 16, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if the topic is not keyed or an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+publish_serialized_message_with_key(
+  const rmw_publisher_t * publisher,
+  const rmw_serialized_message_t * serialized_message,
+  const void * key,
+  size_t key_length);
+
+}  // namespace rmw_connext_cpp
+
+#endif  // RMW_CONNEXT_CPP__KEYED_PUBLISH_HPP_
@@ -0,0 +1,166 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_CPP__LOANED_MESSAGE_HPP_
+#define RMW_CONNEXT_CPP__LOANED_MESSAGE_HPP_
+
+#include <cstddef>
+
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rmw_connext_cpp/visibility_control.h"
+
+namespace rmw_connext_cpp
+{
+
+/// Preallocate the slots which can be loaned from a publisher.
+/**
+ * Loaned messages are meant for large messages of bounded types which are written by the
+ * application directly in their serialized (CDR) form, avoiding the serialization and the
+ * allocation of a buffer on every publish.
+ * Each slot holds a complete serialized message of at most `slot_size` bytes, including the
+ * encapsulation header.
+ * The slots can only be initialized once and are freed when the publisher is destroyed,
+ * all loaned messages must be published or returned before.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if the publisher handle is `NULL` or the sizes are zero, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_BAD_ALLOC` if the slots could not be allocated, or
+ * \return `RMW_RET_ERROR` if the slots have already been initialized or an unexpected
+ *   error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+init_publisher_loans(const rmw_publisher_t * publisher, size_t slot_count, size_t slot_size);
+
+/// Borrow a free slot of a publisher.
+/**
+ * On success `loaned_message` points to the slot, its `buffer_capacity` is the slot size.
+ * The application writes the serialized message into the buffer and sets `buffer_length`
+ * before passing it to `publish_loaned_message()`.
+ * The allocator of `loaned_message` must not be used, the buffer stays owned by the publisher.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if no slots have been initialized or all of them are loaned.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+borrow_loaned_message(
+  const rmw_publisher_t * publisher,
+  rmw_serialized_message_t * loaned_message);
+
+/// Publish a loaned message and give the slot back to the publisher.
+/**
+ * The slot is given back even if publishing fails.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL` or the message has not been
+ *   loaned from this publisher, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+publish_loaned_message(
+  const rmw_publisher_t * publisher,
+  rmw_serialized_message_t * loaned_message);
+
+/// Give a loaned message back to the publisher without publishing it.
+/**
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL` or the message has not been
+ *   loaned from this publisher, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+return_loaned_message(
+  const rmw_publisher_t * publisher,
+  rmw_serialized_message_t * loaned_message);
+
+/// Set the maximum number of messages which can be loaned from a subscription at a time.
+/**
+ * Loaned messages are meant for large read-only messages, they refer to the serialized
+ * sample held by the datareader instead of copying it.
+ * The datareader keeps the resources of a loaned sample until the loan is returned, a
+ * history or resource limit of the subscription can therefore be reached by loans which
+ * are held too long.
+ * The loans can only be initialized once, outstanding loans are returned when the
+ * subscription is destroyed.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if the subscription handle is `NULL` or `max_loans` is
+ *   zero, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the subscription is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_BAD_ALLOC` if the loans could not be allocated, or
+ * \return `RMW_RET_ERROR` if the loans have already been initialized or an unexpected
+ *   error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+init_subscription_loans(const rmw_subscription_t * subscription, size_t max_loans);
+
+/// Take a serialized message from a subscription without copying it.
+/**
+ * On success `loaned_message` points to the serialized message (CDR) held by the
+ * datareader, or shared by a local publisher, and has to be given back with
+ * `return_loaned_message_from_subscription()`.
+ * The buffer must not be modified and its allocator must not be used.
+ *
+ * \param[in] subscription the subscription to take from
+ * \param[out] loaned_message view of the serialized message, if taken
+ * \param[out] taken true if a message has been taken
+ * \param[out] message_info information about the message, can be `NULL`
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the subscription is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if no loans have been initialized, all of them are outstanding or
+ *   an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+take_loaned_message(
+  const rmw_subscription_t * subscription,
+  rmw_serialized_message_t * loaned_message,
+  bool * taken,
+  rmw_message_info_t * message_info);
+
+/// Give a message loaned from a subscription back.
+/**
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL` or the message has not been
+ *   loaned from this subscription, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the subscription is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+return_loaned_message_from_subscription(
+  const rmw_subscription_t * subscription,
+  rmw_serialized_message_t * loaned_message);
+
+}  // namespace rmw_connext_cpp
+
+#endif  // RMW_CONNEXT_CPP__LOANED_MESSAGE_HPP_
@@ -0,0 +1,80 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef RMW_CONNEXT_CPP__REQUEST_LANES_HPP_
+#define RMW_CONNEXT_CPP__REQUEST_LANES_HPP_
+
+#include <cstddef>
+
+#include "rmw/rmw.h"
+#include "rmw/types.h"
+#include "rmw_connext_cpp/visibility_control.h"
+
+namespace rmw_connext_cpp
+{
+
+/// Take the requests of a service from several lanes, in strict priority order.
+/**
+ * Each lane is a DDS partition of the request topic with a datareader of its own, so that
+ * e.g. emergency stop requests are not queued behind bulk requests.
+ * Clients choose their lane with `set_request_lane()`, clients which do not choose one send
+ * to the default lane, which is the datareader the service was created with.
+ * `take_request_serialized()` and `take_requests_serialized()` take the pending requests of a
+ * lane before those of the lanes after it.
+ * The read condition of every lane is attached to the wait set, the service is ready if
+ * any of its lanes has requests.
+ * The lanes can only be initialized once, for services created by
+ * `create_serialized_service()`, before the service is waited on, and are deleted when the
+ * service is destroyed.
+ * Typed services created by `rmw_create_service()` have no lanes, `rmw_take_request()` and
+ * `rmw_wait()` only use the request datareader of their Connext Replier, which the type
+ * support creates and takes the typed samples from itself.
+ *
+ * \param[in] lanes partition names of the lanes in priority order, an empty name is the
+ *   default lane, which is the last lane if it is not listed
+ * \param[in] lane_count number of elements of `lanes`
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL` or a lane is listed twice, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the service is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if the service was not created by `create_serialized_service()`,
+ *   the lanes have already been initialized or an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+init_request_lanes(const rmw_service_t * service, const char * const * lanes, size_t lane_count);
+
+/// Send the requests of a client to a lane of the service.
+/**
+ * The partition of the request publisher of the client is set to the lane.
+ * Only clients created by `create_serialized_client()` have a publisher of their own, the
+ * Connext Requesters of typed clients use the implicit publisher of their node.
+ * Clients sharing the request datawriter of their node (see
+ * `RMW_CONNEXT_SHARED_REQUESTER_TOPICS`) can not choose a lane either.
+ * Requests sent before are not moved to the lane.
+ *
+ * \param[in] lane partition name of the lane, or an empty name for the default lane
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the client is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if the client was not created by `create_serialized_client()`,
+ *   shares its request datawriter or an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+set_request_lane(const rmw_client_t * client, const char * lane);
+
+}  // namespace rmw_connext_cpp
+
+#endif  // RMW_CONNEXT_CPP__REQUEST_LANES_HPP_
@@ -0,0 +1,94 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_CPP__REQUEST_TIME_TABLE_HPP_
+#define RMW_CONNEXT_CPP__REQUEST_TIME_TABLE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+
+/// Times at which the requests of a client were sent or those of a service were taken.
+/**
+ * Requests are usually answered in the order they arrive, so the table is searched from
+ * the oldest request on.
+ * Requests which are never answered are forgotten once the table is full.
+ */
+class RequestTimeTable
+{
+public:
+  static constexpr size_t max_size = 1024;
+
+  /// Remember the current time for a request.
+  /**
+   * \param writer_guid GUID of the request writer of the client, or `nullptr` for the
+   *   requests of a single client
+   */
+  void add(const int8_t * writer_guid, int64_t sequence_number)
+  {
+    Entry entry;
+    if (writer_guid) {
+      memcpy(entry.writer_guid, writer_guid, sizeof(entry.writer_guid));
+    } else {
+      memset(entry.writer_guid, 0, sizeof(entry.writer_guid));
+    }
+    entry.sequence_number = sequence_number;
+    entry.time = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.size() >= max_size) {
+      entries_.pop_front();
+    }
+    entries_.push_back(entry);
+  }
+
+  /// Forget a request and get the time passed since it was added.
+  /**
+   * \return false if the request is unknown
+   */
+  bool remove(
+    const int8_t * writer_guid, int64_t sequence_number, std::chrono::nanoseconds & elapsed)
+  {
+    int8_t zero_guid[sizeof(Entry::writer_guid)] = {};
+    if (!writer_guid) {
+      writer_guid = zero_guid;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->sequence_number == sequence_number &&
+        !memcmp(it->writer_guid, writer_guid, sizeof(it->writer_guid)))
+      {
+        elapsed = std::chrono::steady_clock::now() - it->time;
+        entries_.erase(it);
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  struct Entry
+  {
+    int8_t writer_guid[16];
+    int64_t sequence_number;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  std::mutex mutex_;
+  std::deque<Entry> entries_;
+};
+
+#endif  // RMW_CONNEXT_CPP__REQUEST_TIME_TABLE_HPP_
@@ -0,0 +1,72 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_CPP__REQUEST_WINDOW_HPP_
+#define RMW_CONNEXT_CPP__REQUEST_WINDOW_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rmw/rmw.h"
+#include "rmw/types.h"
+#include "rmw_connext_cpp/visibility_control.h"
+
+namespace rmw_connext_cpp
+{
+
+/// Track the requests of a client until they are answered or expire.
+/**
+ * Sending a request returns `RMW_RET_TIMEOUT` while `max_in_flight` requests are waiting for
+ * their responses.
+ * A request expires once it waited for `timeout`, then the client is made ready by the
+ * wait set and the sequence number of the request can be taken by
+ * `take_expired_request()`.
+ * Responses to expired requests are dropped when taken, for serialized clients before the
+ * response is copied, for typed clients after it was deserialized.
+ * The window can only be initialized once, before the first request is sent, and is freed
+ * when the client is destroyed.
+ *
+ * \param max_in_flight maximum number of requests waiting for a response, or 0 for no limit
+ * \param timeout time a request waits for its response, or zero to wait forever
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if the client handle is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the client is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_BAD_ALLOC` if the window could not be allocated, or
+ * \return `RMW_RET_ERROR` if the window has already been initialized or an unexpected
+ *   error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+init_request_window(const rmw_client_t * client, size_t max_in_flight, rmw_time_t timeout);
+
+/// Take the sequence number of a request which expired without a response.
+/**
+ * The latest expired requests are kept, up to `max_in_flight` of them or 1024 without a
+ * limit.
+ *
+ * \param[out] sequence_id sequence number of the request, as returned when sending it
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the client is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if the window has not been initialized.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+take_expired_request(const rmw_client_t * client, int64_t * sequence_id, bool * taken);
+
+}  // namespace rmw_connext_cpp
+
+#endif  // RMW_CONNEXT_CPP__REQUEST_WINDOW_HPP_
@@ -0,0 +1,194 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef RMW_CONNEXT_CPP__SERIALIZED_SERVICE_HPP_
+#define RMW_CONNEXT_CPP__SERIALIZED_SERVICE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rmw_connext_cpp/visibility_control.h"
+
+namespace rmw_connext_cpp
+{
+
+/// Create a client which sends requests and takes responses as serialized messages.
+/**
+ * Works like `rmw_create_client()`, but the requests and responses are written and read as
+ * CDR, the same way messages of topics are, instead of being converted from and to the
+ * typed samples of a Connext Requester.
+ * The client talks to typed services and to services created by
+ * `create_serialized_service()` alike.
+ * The replies are read through a content filter on the GUID of the request datawriter,
+ * which the reply datawriters of services of this rmw evaluate, so that a client only
+ * receives the replies to its own requests.
+ * A node can not have serialized and typed clients or services of the same service type,
+ * creating one of the other kind fails.
+ * The clients of a node whose request topic is listed in `RMW_CONNEXT_SHARED_REQUESTER_TOPICS`
+ * share one request datawriter and response datareader, the first client sets their qos.
+ * The entities are only shared within a node, since each node has a participant of its own,
+ * and only by serialized clients. Typed clients created by `rmw_create_client()` always
+ * have a Connext Requester of their own, which the type support creates together with its
+ * entities and which writes and takes the typed samples itself.
+ * The client is destroyed by `rmw_destroy_client()`.
+ *
+ * \return rmw client handle or `NULL` if there was an error
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_client_t *
+create_serialized_client(
+  const rmw_node_t * node,
+  const rosidl_service_type_support_t * type_supports,
+  const char * service_name,
+  const rmw_qos_profile_t * qos_profile);
+
+/// Create a service which takes requests and sends responses as serialized messages.
+/**
+ * Works like `create_serialized_client()` for the server side of a service.
+ * The service is destroyed by `rmw_destroy_service()`.
+ *
+ * \return rmw service handle or `NULL` if there was an error
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_service_t *
+create_serialized_service(
+  const rmw_node_t * node,
+  const rosidl_service_type_support_t * type_supports,
+  const char * service_name,
+  const rmw_qos_profile_t * qos_profile);
+
+/// Send a serialized request.
+/**
+ * \param[out] sequence_id sequence number of the request, as in the header of its response
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_TIMEOUT` if the request queue of the service is full, see
+ *   `RMW_CONNEXT_REQUEST_QUEUE_TOPICS`, or too many requests are in flight, see
+ *   `init_request_window()`, or
+ * \return `RMW_RET_ERROR` if the client was not created by `create_serialized_client()` or
+ *   an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+send_request_serialized(
+  const rmw_client_t * client,
+  const rmw_serialized_message_t * request,
+  int64_t * sequence_id);
+
+/// Take a serialized response to a request of the client.
+/**
+ * The buffer of the serialized message is only grown if the response does not fit.
+ *
+ * \param[out] request_header identity of the request answered by the response
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_ERROR` if the client was not created by `create_serialized_client()` or
+ *   an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+take_response_serialized(
+  const rmw_client_t * client,
+  rmw_request_id_t * request_header,
+  rmw_serialized_message_t * response,
+  bool * taken);
+
+/// Take a serialized request.
+/**
+ * The buffer of the serialized message is only grown if the request does not fit.
+ *
+ * \param[out] request_header identity of the request, to be passed to the response
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_ERROR` if the service was not created by `create_serialized_service()`
+ *   or an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+take_request_serialized(
+  const rmw_service_t * service,
+  rmw_request_id_t * request_header,
+  rmw_serialized_message_t * request,
+  bool * taken);
+
+/// Send a serialized response to a request.
+/**
+ * A response which can not be queued within `RMW_CONNEXT_RESPONSE_TIMEOUT_US` is dropped
+ * and counted in the `ServiceStatistics`, like with `rmw_send_response()`.
+ *
+ * \param[in] request_header identity of the request, as taken with it
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_ERROR` if the service was not created by `create_serialized_service()`
+ *   or an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+send_response_serialized(
+  const rmw_service_t * service,
+  const rmw_request_id_t * request_header,
+  const rmw_serialized_message_t * response);
+
+/// Take up to `count` serialized requests at once.
+/**
+ * Pending requests are taken with as few datareader loans as possible, which saves a
+ * call and a wake up of the executor per request for services handling many small
+ * requests.
+ * The buffers of the serialized messages are only grown if a request does not fit.
+ *
+ * \param[in] count number of elements of `request_headers` and `requests`
+ * \param[out] request_headers identities of the requests, to be passed to the responses
+ * \param[out] requests serialized messages the requests are copied to
+ * \param[out] taken_count number of requests taken, less than `count` if no more were pending
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_ERROR` if the service was not created by `create_serialized_service()`
+ *   or an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+take_requests_serialized(
+  const rmw_service_t * service,
+  size_t count,
+  rmw_request_id_t * request_headers,
+  rmw_serialized_message_t * requests,
+  size_t * taken_count);
+
+/// Send `count` serialized responses at once.
+/**
+ * The responses are written in order and the datawriter is flushed after the last one,
+ * so that responses collected in a batch (see `RMW_CONNEXT_BATCH_TOPICS`, the topic of
+ * the responses is "rr/<service name>Reply") are sent without waiting for the flush
+ * delay.
+ * If a response can not be written, the following ones are not sent.
+ *
+ * \param[in] count number of elements of `request_headers` and `responses`
+ * \param[in] request_headers identities of the requests, as taken with them
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_ERROR` if the service was not created by `create_serialized_service()`
+ *   or an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+send_responses_serialized(
+  const rmw_service_t * service,
+  size_t count,
+  const rmw_request_id_t * request_headers,
+  const rmw_serialized_message_t * responses);
+
+}  // namespace rmw_connext_cpp
+
+#endif  // RMW_CONNEXT_CPP__SERIALIZED_SERVICE_HPP_
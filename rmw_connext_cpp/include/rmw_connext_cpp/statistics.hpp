@@ -0,0 +1,175 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_CPP__STATISTICS_HPP_
+#define RMW_CONNEXT_CPP__STATISTICS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rmw/rmw.h"
+#include "rmw_connext_cpp/visibility_control.h"
+
+namespace rmw_connext_cpp
+{
+
+constexpr size_t time_histogram_bucket_count = 32;
+
+/// Distribution of the durations of an operation.
+struct TimeHistogram
+{
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  // Bucket 0 counts durations below 1 us, bucket i durations in [2^(i-1), 2^i) us,
+  // the last bucket also counts all longer durations.
+  uint64_t buckets[time_histogram_bucket_count];
+};
+
+/// Counters of a publisher since its creation.
+struct PublisherStatistics
+{
+  // samples and bytes sent by the datawriter for the first time
+  uint64_t messages_sent;
+  uint64_t bytes_sent;
+  // samples and bytes sent again on request of a reliable datareader
+  uint64_t messages_resent;
+  uint64_t bytes_resent;
+  // samples not sent to a datareader because of its content filter
+  uint64_t messages_filtered;
+  // time spent in rmw_publish() converting messages to their serialized form
+  TimeHistogram serialize_time;
+};
+
+/// Counters of a subscription since its creation.
+struct SubscriptionStatistics
+{
+  // samples and bytes received by the datareader
+  uint64_t messages_received;
+  uint64_t bytes_received;
+  // samples received more than once, e.g. because of a resend
+  uint64_t messages_duplicate;
+  // samples which never reached the datareader
+  uint64_t messages_lost;
+  // samples dropped by the datareader because of its resource limits
+  uint64_t messages_rejected;
+  // time spent in rmw_take() converting serialized messages to messages
+  TimeHistogram deserialize_time;
+};
+
+/// Counters of a client since its creation.
+struct ClientStatistics
+{
+  uint64_t requests_sent;
+  // time from sending a request until taking its response
+  TimeHistogram round_trip_time;
+};
+
+/// Counters of a service since its creation.
+struct ServiceStatistics
+{
+  uint64_t requests_taken;
+  // responses dropped because the datawriter stayed full past RMW_CONNEXT_RESPONSE_TIMEOUT_US
+  uint64_t responses_dropped;
+  // time from taking a request until sending its response, spent by the server
+  TimeHistogram response_time;
+};
+
+/// Get the counters of a publisher.
+/**
+ * The counters kept by the rmw implementation are read without locking, so that this
+ * can be polled periodically next to publishing.
+ * The sent samples are taken from the protocol status of the datawriter.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if the protocol status could not be retrieved.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+get_publisher_statistics(
+  const rmw_publisher_t * publisher,
+  PublisherStatistics * statistics);
+
+/// Get the counters of a subscription.
+/**
+ * The counters kept by the rmw implementation are read without locking, so that this
+ * can be polled periodically next to taking.
+ * The received samples are taken from the protocol status of the datareader.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the subscription is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if the protocol status could not be retrieved.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+get_subscription_statistics(
+  const rmw_subscription_t * subscription,
+  SubscriptionStatistics * statistics);
+
+/// Get the counters of a client.
+/**
+ * The counters are read without locking, so that this can be polled periodically next to
+ * sending requests.
+ * The round trip times only include the responses taken by the client, not those to
+ * requests which expired or were forgotten after more than 1024 requests waited.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the client is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+get_client_statistics(
+  const rmw_client_t * client,
+  ClientStatistics * statistics);
+
+/// Get the counters of a service.
+/**
+ * Works like `get_client_statistics()`, the response times are measured for the responses
+ * sent to requests taken by the service.
+ *
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if an argument is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the service is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+get_service_statistics(
+  const rmw_service_t * service,
+  ServiceStatistics * statistics);
+
+/// Estimate a percentile of the durations of a histogram.
+/**
+ * The estimate is the upper bound of the bucket the percentile falls into, which is at
+ * most twice the actual duration, and never more than the longest duration.
+ *
+ * \param[in] percentile between 0 and 100, e.g. 99.9
+ * \return duration in nanoseconds, or 0 if the histogram is empty
+ */
+RMW_CONNEXT_CPP_PUBLIC
+uint64_t
+get_time_histogram_percentile(const TimeHistogram & histogram, double percentile);
+
+}  // namespace rmw_connext_cpp
+
+#endif  // RMW_CONNEXT_CPP__STATISTICS_HPP_
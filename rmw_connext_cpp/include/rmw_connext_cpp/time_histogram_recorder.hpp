@@ -0,0 +1,77 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_CPP__TIME_HISTOGRAM_RECORDER_HPP_
+#define RMW_CONNEXT_CPP__TIME_HISTOGRAM_RECORDER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "rmw_connext_cpp/statistics.hpp"
+
+/// Lock-free recorder of a rmw_connext_cpp::TimeHistogram.
+class TimeHistogramRecorder
+{
+public:
+  TimeHistogramRecorder()
+  : count_(0), total_ns_(0), max_ns_(0)
+  {
+    for (auto & bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void record(std::chrono::nanoseconds duration)
+  {
+    uint64_t ns = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+    // the bucket is the bit width of the duration in microseconds
+    size_t bucket = 0;
+    for (uint64_t us = ns / 1000; us; us >>= 1) {
+      ++bucket;
+    }
+    if (bucket >= rmw_connext_cpp::time_histogram_bucket_count) {
+      bucket = rmw_connext_cpp::time_histogram_bucket_count - 1;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max_ns = max_ns_.load(std::memory_order_relaxed);
+    while (ns > max_ns &&
+      !max_ns_.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed))
+    {
+      // max_ns has been updated to the current maximum, try again
+    }
+    count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// Copy the histogram, concurrently recorded durations may be missing from some fields.
+  void get(rmw_connext_cpp::TimeHistogram & histogram) const
+  {
+    histogram.count = count_.load(std::memory_order_relaxed);
+    histogram.total_ns = total_ns_.load(std::memory_order_relaxed);
+    histogram.max_ns = max_ns_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < rmw_connext_cpp::time_histogram_bucket_count; ++i) {
+      histogram.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+  }
+
+private:
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> total_ns_;
+  std::atomic<uint64_t> max_ns_;
+  std::atomic<uint64_t> buckets_[rmw_connext_cpp::time_histogram_bucket_count];
+};
+
+#endif  // RMW_CONNEXT_CPP__TIME_HISTOGRAM_RECORDER_HPP_
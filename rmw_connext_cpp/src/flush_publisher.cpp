@@ -0,0 +1,53 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rmw/error_handling.h"
+#include "rmw/impl/cpp/macros.hpp"
+
+#include "rmw_connext_cpp/flush_publisher.hpp"
+
+#include "rmw_connext_cpp/connext_static_publisher_info.hpp"
+#include "rmw_connext_cpp/identifier.hpp"
+
+namespace rmw_connext_cpp
+{
+
+rmw_ret_t
+flush_publisher(const rmw_publisher_t * publisher)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+
+  auto publisher_info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!publisher_info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return RMW_RET_ERROR;
+  }
+  DDS::DataWriter * topic_writer = publisher_info->topic_writer_;
+  if (!topic_writer) {
+    RMW_SET_ERROR_MSG("topic writer handle is null");
+    return RMW_RET_ERROR;
+  }
+
+  if (topic_writer->flush() != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to flush data writer");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
+
+}  // namespace rmw_connext_cpp
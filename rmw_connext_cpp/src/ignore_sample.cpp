@@ -0,0 +1,51 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ignore_sample.hpp"
+#include "intra_process.hpp"
+
+bool
+_ignore_sample(
+  DDS::DataReader * dds_data_reader,
+  const DDS::SampleInfo & sample_info,
+  bool ignore_local_publications,
+  const IntraProcessSubscription * intra_process)
+{
+  if (!sample_info.valid_data) {
+    // skip sample without data
+    return true;
+  }
+  if (intra_process &&
+    intra_process->is_intra_process_publication(sample_info.publication_handle))
+  {
+    // the sample has already been delivered in process
+    return true;
+  }
+  if (!ignore_local_publications) {
+    return false;
+  }
+  // compare the lower 12 octets of the guids from the sender and this receiver
+  // if they are equal the sample has been sent from this process and should be ignored
+  DDS::GUID_t sender_guid = sample_info.original_publication_virtual_guid;
+  DDS::InstanceHandle_t receiver_instance_handle = dds_data_reader->get_instance_handle();
+  for (size_t i = 0; i < 12; ++i) {
+    DDS::Octet * sender_element = &(sender_guid.value[i]);
+    DDS::Octet * receiver_element =
+      &(reinterpret_cast<DDS::Octet *>(&receiver_instance_handle)[i]);
+    if (*sender_element != *receiver_element) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,34 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IGNORE_SAMPLE_HPP_
+#define IGNORE_SAMPLE_HPP_
+
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+
+class IntraProcessSubscription;
+
+/// Check if a sample taken from the datareader of a subscription must not be passed on.
+/**
+ * Samples without data, samples which have already been delivered in process and, if
+ * requested, samples sent by the same participant are ignored.
+ */
+bool
+_ignore_sample(
+  DDS::DataReader * dds_data_reader,
+  const DDS::SampleInfo & sample_info,
+  bool ignore_local_publications,
+  const IntraProcessSubscription * intra_process);
+
+#endif  // IGNORE_SAMPLE_HPP_
@@ -0,0 +1,188 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+
+#include "in_flight_requests.hpp"
+
+static int64_t
+now_nanoseconds()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+InFlightRequests::InFlightRequests(size_t max_in_flight, int64_t timeout_ns)
+: max_in_flight_(max_in_flight),
+  timeout_ns_(timeout_ns),
+  in_flight_count_(0),
+  reserved_count_(0),
+  last_expired_sequence_id_((std::numeric_limits<int64_t>::min)())
+{}
+
+bool
+InFlightRequests::reserve()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (max_in_flight_ && in_flight_count_ >= max_in_flight_ && timeout_ns_) {
+    expire(now_nanoseconds());
+  }
+  if (max_in_flight_ && in_flight_count_ >= max_in_flight_) {
+    return false;
+  }
+  ++in_flight_count_;
+  ++reserved_count_;
+  return true;
+}
+
+void
+InFlightRequests::add(int64_t sequence_id)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  --reserved_count_;
+  auto completed = std::find(completed_early_.begin(), completed_early_.end(), sequence_id);
+  if (completed != completed_early_.end()) {
+    completed_early_.erase(completed);
+    --in_flight_count_;
+  } else {
+    Request request;
+    request.sequence_id = sequence_id;
+    request.deadline = timeout_ns_ ? now_nanoseconds() + timeout_ns_ : 0;
+    request.completed = false;
+    // concurrent senders may add their requests out of order
+    auto it = requests_.end();
+    while (it != requests_.begin() && (it - 1)->sequence_id > sequence_id) {
+      --it;
+    }
+    requests_.insert(it, request);
+  }
+  if (!reserved_count_) {
+    completed_early_.clear();
+  }
+}
+
+void
+InFlightRequests::cancel()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  --reserved_count_;
+  --in_flight_count_;
+  if (!reserved_count_) {
+    completed_early_.clear();
+  }
+}
+
+bool
+InFlightRequests::complete(int64_t sequence_id)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::lower_bound(
+    requests_.begin(), requests_.end(), sequence_id,
+    [](const Request & request, int64_t sequence_id) {
+      return request.sequence_id < sequence_id;
+    });
+  if (it == requests_.end() || it->sequence_id != sequence_id) {
+    // the response of a request being added overtook it
+    if (reserved_count_ && sequence_id > last_expired_sequence_id_) {
+      completed_early_.push_back(sequence_id);
+      return true;
+    }
+    return false;
+  }
+  if (it->completed) {
+    return false;
+  }
+  it->completed = true;
+  --in_flight_count_;
+  while (!requests_.empty() && requests_.front().completed) {
+    requests_.pop_front();
+  }
+  return true;
+}
+
+int64_t
+InFlightRequests::expire()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return expire(now_nanoseconds());
+}
+
+int64_t
+InFlightRequests::expire(int64_t now)
+{
+  if (!timeout_ns_) {
+    return -1;
+  }
+  const size_t max_expired_count = max_in_flight_ ? max_in_flight_ : 1024;
+  bool expired = false;
+  int64_t next_deadline_ns = -1;
+  while (!requests_.empty()) {
+    const Request & request = requests_.front();
+    if (!request.completed) {
+      if (request.deadline > now) {
+        next_deadline_ns = request.deadline - now;
+        break;
+      }
+      if (expired_.size() >= max_expired_count) {
+        expired_.pop_front();
+      }
+      expired_.push_back(request.sequence_id);
+      last_expired_sequence_id_ = (std::max)(last_expired_sequence_id_, request.sequence_id);
+      --in_flight_count_;
+      expired = true;
+    }
+    requests_.pop_front();
+  }
+  if (expired) {
+    condition_.set_trigger_value(DDS::BOOLEAN_TRUE);
+  }
+  return next_deadline_ns;
+}
+
+int64_t
+InFlightRequests::get_last_expired_sequence_id()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_expired_sequence_id_;
+}
+
+bool
+InFlightRequests::take_expired(int64_t & sequence_id)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (expired_.empty()) {
+    condition_.set_trigger_value(DDS::BOOLEAN_FALSE);
+    return false;
+  }
+  sequence_id = expired_.front();
+  expired_.pop_front();
+  return true;
+}
+
+void
+InFlightRequests::reset_condition()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  condition_.set_trigger_value(DDS::BOOLEAN_FALSE);
+}
+
+DDS::GuardCondition *
+InFlightRequests::get_condition()
+{
+  return &condition_;
+}
@@ -0,0 +1,155 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IN_FLIGHT_REQUESTS_HPP_
+#define IN_FLIGHT_REQUESTS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+
+/// Requests of a client waiting for their responses, each with a deadline.
+/**
+ * The deadlines follow the order of the sequence numbers, since all requests of a client
+ * have the same timeout, so that the request expiring next is always the oldest one.
+ */
+class InFlightRequests
+{
+public:
+  /// Track requests of a client.
+  /**
+   * \param max_in_flight maximum number of requests waiting for a response, or 0
+   * \param timeout_ns time a request waits for its response, or 0 to wait forever
+   */
+  InFlightRequests(size_t max_in_flight, int64_t timeout_ns);
+
+  /// Expire the requests past their deadline and reserve a slot for a request to be sent.
+  /**
+   * The slot is filled by `add()` once the request is written, or released by `cancel()`.
+   *
+   * \return false if the maximum number of requests is in flight
+   */
+  bool
+  reserve();
+
+  /// Start tracking a request which has just been written in a reserved slot.
+  void
+  add(int64_t sequence_id);
+
+  /// Release a reserved slot, because the request could not be written.
+  void
+  cancel();
+
+  /// Stop tracking the request answered by a response.
+  /**
+   * A response may be taken before its request is added, while a slot is reserved, in which
+   * case it is accepted if it is newer than the requests which expired.
+   *
+   * \return false if the request is not in flight, because it expired or is unknown
+   */
+  bool
+  complete(int64_t sequence_id);
+
+  /// Expire the requests past their deadline.
+  /**
+   * The condition is triggered if any request expired.
+   *
+   * \return nanoseconds until the next deadline, or -1 if no request has a deadline
+   */
+  int64_t
+  expire();
+
+  /// Get the sequence number of the newest request which expired, older ones expired too.
+  int64_t
+  get_last_expired_sequence_id();
+
+  /// Take the sequence number of the next expired request, if any.
+  bool
+  take_expired(int64_t & sequence_id);
+
+  /// Reset the condition, after the client was woken up by it.
+  void
+  reset_condition();
+
+  DDS::GuardCondition *
+  get_condition();
+
+private:
+  struct Request
+  {
+    int64_t sequence_id;
+    int64_t deadline;
+    bool completed;
+  };
+
+  int64_t
+  expire(int64_t now);
+
+  std::mutex mutex_;
+  size_t max_in_flight_;
+  int64_t timeout_ns_;
+  // requests in the order they were sent, completed ones are removed once they are oldest
+  std::deque<Request> requests_;
+  // requests in flight, including the reserved slots
+  size_t in_flight_count_;
+  size_t reserved_count_;
+  // requests completed while their slot was still reserved, checked by add()
+  std::vector<int64_t> completed_early_;
+  int64_t last_expired_sequence_id_;
+  // only the latest expired requests are kept, up to the maximum in flight or 1024
+  std::deque<int64_t> expired_;
+  DDS::GuardCondition condition_;
+};
+
+/// Slot reserved for a request to be sent, released unless the request was added.
+/**
+ * Releases the slot when the request could not be written, also when writing throws.
+ */
+class InFlightReservation
+{
+public:
+  /// Take over the slot reserved with `in_flight`, if any.
+  explicit InFlightReservation(InFlightRequests * in_flight)
+  : in_flight_(in_flight)
+  {}
+
+  ~InFlightReservation()
+  {
+    if (in_flight_) {
+      in_flight_->cancel();
+    }
+  }
+
+  InFlightReservation(const InFlightReservation &) = delete;
+  InFlightReservation & operator=(const InFlightReservation &) = delete;
+
+  /// Fill the slot with the request which has just been written.
+  void
+  add(int64_t sequence_id)
+  {
+    if (in_flight_) {
+      in_flight_->add(sequence_id);
+      in_flight_ = nullptr;
+    }
+  }
+
+private:
+  InFlightRequests * in_flight_;
+};
+
+#endif  // IN_FLIGHT_REQUESTS_HPP_
@@ -0,0 +1,394 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "rmw_connext_shared_cpp/environment.hpp"
+
+#include "intra_process.hpp"
+
+IntraProcessQueue::IntraProcessQueue(size_t depth)
+: mask_(0), depth_((std::max)(depth, static_cast<size_t>(1))),
+  enqueue_position_(0), dequeue_position_(0)
+{
+  // the number of cells has to be a power of two to map positions to cells with a mask
+  size_t size = 2;
+  while (size < depth_) {
+    size *= 2;
+  }
+  cells_.reset(new Cell[size]);
+  for (size_t i = 0; i < size; ++i) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  mask_ = size - 1;
+}
+
+void
+IntraProcessQueue::push(IntraProcessMessage && message)
+{
+  IntraProcessMessage dropped;
+  while (!try_push(message)) {
+    // the cells are full, make room for the latest message
+    pop(dropped);
+  }
+  for (;; ) {
+    // the dequeue position is loaded first, so that it never passes the enqueue position
+    size_t dequeue_position = dequeue_position_.load(std::memory_order_acquire);
+    size_t enqueue_position = enqueue_position_.load(std::memory_order_acquire);
+    if (enqueue_position - dequeue_position <= depth_ || !pop(dropped)) {
+      break;
+    }
+  }
+}
+
+bool
+IntraProcessQueue::try_push(IntraProcessMessage & message)
+{
+  Cell * cell;
+  size_t position = enqueue_position_.load(std::memory_order_relaxed);
+  for (;; ) {
+    cell = &cells_[position & mask_];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (difference == 0) {
+      if (enqueue_position_.compare_exchange_weak(
+          position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    } else if (difference < 0) {
+      // the cell still holds a message from the previous lap, the queue is full
+      return false;
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+  cell->message = std::move(message);
+  cell->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool
+IntraProcessQueue::pop(IntraProcessMessage & message)
+{
+  Cell * cell;
+  size_t position = dequeue_position_.load(std::memory_order_relaxed);
+  for (;; ) {
+    cell = &cells_[position & mask_];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t difference =
+      static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+    if (difference == 0) {
+      if (dequeue_position_.compare_exchange_weak(
+          position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    } else if (difference < 0) {
+      // the cell has not been filled yet, the queue is empty
+      return false;
+    } else {
+      position = dequeue_position_.load(std::memory_order_relaxed);
+    }
+  }
+  message = std::move(cell->message);
+  cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+  return true;
+}
+
+bool
+IntraProcessQueue::empty() const
+{
+  return dequeue_position_.load(std::memory_order_acquire) ==
+         enqueue_position_.load(std::memory_order_acquire);
+}
+
+static int64_t
+now_nanoseconds()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::shared_ptr<const IntraProcessTopic::Endpoints>
+IntraProcessTopic::get_endpoints() const
+{
+  return std::atomic_load(&endpoints_);
+}
+
+template<typename UpdateT>
+void
+IntraProcessTopic::update_endpoints(UpdateT update)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto endpoints = std::make_shared<Endpoints>(*std::atomic_load(&endpoints_));
+  update(*endpoints);
+  std::atomic_store(&endpoints_, std::shared_ptr<const Endpoints>(std::move(endpoints)));
+  ++changes_;
+}
+
+// Only subscriptions with a keep last history are delivered in process.
+static size_t
+get_queue_depth(const DDS::DataReaderQos & datareader_qos)
+{
+  return static_cast<size_t>((std::max)(datareader_qos.history.depth, 1));
+}
+
+IntraProcessReceiver::IntraProcessReceiver(
+  DDS::DataReader * topic_reader,
+  const DDS::DataReaderQos & datareader_qos,
+  bool ignore_local_publications)
+: reader_handle(topic_reader->get_instance_handle()),
+  participant_handle(
+    topic_reader->get_subscriber()->get_participant()->get_instance_handle()),
+  reliable(datareader_qos.reliability.kind == DDS::RELIABLE_RELIABILITY_QOS),
+  ignore_local_publications(ignore_local_publications),
+  queue(get_queue_depth(datareader_qos))
+{}
+
+void
+IntraProcessReceiver::deliver(const IntraProcessMessage & message)
+{
+  IntraProcessMessage copy = message;
+  copy.reception_timestamp = now_nanoseconds();
+  // keep the latest messages like the keep last history of the subscription
+  queue.push(std::move(copy));
+  condition.set_trigger_value(DDS::BOOLEAN_TRUE);
+}
+
+IntraProcessSubscription::IntraProcessSubscription(
+  std::shared_ptr<IntraProcessTopic> topic,
+  DDS::DataReader * topic_reader,
+  const DDS::DataReaderQos & datareader_qos,
+  bool ignore_local_publications)
+: topic_(std::move(topic)),
+  receiver_(
+    std::make_shared<IntraProcessReceiver>(
+      topic_reader, datareader_qos, ignore_local_publications))
+{
+  topic_->update_endpoints(
+    [this](IntraProcessTopic::Endpoints & endpoints) {
+      endpoints.receivers.push_back(receiver_);
+    });
+}
+
+IntraProcessSubscription::~IntraProcessSubscription()
+{
+  topic_->update_endpoints(
+    [this](IntraProcessTopic::Endpoints & endpoints) {
+      auto & receivers = endpoints.receivers;
+      receivers.erase(
+        std::remove(receivers.begin(), receivers.end(), receiver_), receivers.end());
+    });
+}
+
+bool
+IntraProcessSubscription::take(IntraProcessMessage & message)
+{
+  if (receiver_->queue.pop(message)) {
+    return true;
+  }
+  // reset the trigger before checking again, so that a message pushed concurrently
+  // triggers the condition either way
+  receiver_->condition.set_trigger_value(DDS::BOOLEAN_FALSE);
+  if (!receiver_->queue.empty()) {
+    receiver_->condition.set_trigger_value(DDS::BOOLEAN_TRUE);
+  }
+  return false;
+}
+
+bool
+IntraProcessSubscription::is_intra_process_publication(
+  const DDS::InstanceHandle_t & publication_handle) const
+{
+  return topic_->is_local_writer(publication_handle);
+}
+
+DDS::GuardCondition *
+IntraProcessSubscription::get_condition()
+{
+  return &receiver_->condition;
+}
+
+IntraProcessPublisher::IntraProcessPublisher(
+  std::shared_ptr<IntraProcessTopic> topic,
+  DDS::DataWriter * topic_writer,
+  const DDS::DataWriterQos & datawriter_qos)
+: topic_(std::move(topic)),
+  topic_writer_(topic_writer),
+  writer_handle_(topic_writer->get_instance_handle()),
+  participant_handle_(
+    topic_writer->get_publisher()->get_participant()->get_instance_handle()),
+  reliable_(datawriter_qos.reliability.kind == DDS::RELIABLE_RELIABILITY_QOS),
+  sequence_number_(0),
+  checked_match_changes_((std::numeric_limits<uint64_t>::max)()),
+  checked_topic_changes_((std::numeric_limits<uint64_t>::max)()),
+  has_remote_subscriptions_(true)
+{
+  topic_->update_endpoints(
+    [this](IntraProcessTopic::Endpoints & endpoints) {
+      endpoints.writer_handles.push_back(writer_handle_);
+    });
+}
+
+IntraProcessPublisher::~IntraProcessPublisher()
+{
+  topic_->update_endpoints(
+    [this](IntraProcessTopic::Endpoints & endpoints) {
+      auto & writer_handles = endpoints.writer_handles;
+      auto it = std::find_if(
+        writer_handles.begin(), writer_handles.end(),
+        [this](const DDS::InstanceHandle_t & writer_handle) {
+          return DDS_InstanceHandle_equals(&writer_handle, &writer_handle_);
+        });
+      if (it != writer_handles.end()) {
+        writer_handles.erase(it);
+      }
+    });
+}
+
+bool
+IntraProcessPublisher::has_local_subscriptions() const
+{
+  return !topic_->get_endpoints()->receivers.empty();
+}
+
+void
+IntraProcessPublisher::publish(std::shared_ptr<const uint8_t> buffer, size_t buffer_length)
+{
+  IntraProcessMessage message;
+  message.buffer = std::move(buffer);
+  message.buffer_length = buffer_length;
+  message.publication_handle = writer_handle_;
+  message.source_timestamp = now_nanoseconds();
+  message.sequence_number = ++sequence_number_;
+
+  std::shared_ptr<const IntraProcessTopic::Endpoints> endpoints = topic_->get_endpoints();
+  for (const auto & receiver : endpoints->receivers) {
+    // Connext would not match a best effort writer with a reliable reader
+    if (receiver->reliable && !reliable_) {
+      continue;
+    }
+    if (receiver->ignore_local_publications &&
+      DDS_InstanceHandle_equals(&receiver->participant_handle, &participant_handle_))
+    {
+      continue;
+    }
+    receiver->deliver(message);
+  }
+}
+
+bool
+IntraProcessPublisher::has_remote_subscriptions(uint64_t match_changes)
+{
+  uint64_t topic_changes = topic_->changes_.load();
+  if (match_changes == checked_match_changes_ && topic_changes == checked_topic_changes_) {
+    return has_remote_subscriptions_;
+  }
+
+  DDS::InstanceHandleSeq subscription_handles;
+  if (topic_writer_->get_matched_subscriptions(subscription_handles) != DDS::RETCODE_OK) {
+    // rather write once too often than miss a subscription
+    return true;
+  }
+  bool has_remote_subscriptions = false;
+  for (DDS::Long i = 0; i < subscription_handles.length(); ++i) {
+    if (!topic_->is_local_reader(subscription_handles[i])) {
+      has_remote_subscriptions = true;
+      break;
+    }
+  }
+  has_remote_subscriptions_ = has_remote_subscriptions;
+  checked_match_changes_ = match_changes;
+  checked_topic_changes_ = topic_changes;
+  return has_remote_subscriptions;
+}
+
+IntraProcessTopic::IntraProcessTopic()
+: endpoints_(std::make_shared<const Endpoints>()), changes_(0)
+{}
+
+bool
+IntraProcessTopic::get(
+  const rmw_context_t * context,
+  DDS::DomainParticipant * participant,
+  const char * topic_name,
+  const std::string & type_name,
+  std::shared_ptr<IntraProcessTopic> & topic)
+{
+  static std::mutex registry_mutex;
+  static std::map<std::string, std::weak_ptr<IntraProcessTopic>> registry;
+
+  topic.reset();
+  std::string topics;
+  if (!get_env_string(RMW_CONNEXT_INTRA_PROCESS_TOPICS_ENV_VAR, topics)) {
+    return false;
+  }
+  if (!topic_name_matches(topics, topic_name)) {
+    return true;
+  }
+
+  // endpoints of different contexts do not see each other, even within one domain
+  std::string key =
+    std::to_string(reinterpret_cast<uintptr_t>(context)) + "/" +
+    std::to_string(context->instance_id) + "/" +
+    std::to_string(participant->get_domain_id()) + "/" + topic_name + "/" + type_name;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (auto it = registry.begin(); it != registry.end(); ) {
+    // drop the topics whose endpoints are all gone, e.g. those of finalized contexts
+    if (it->second.expired()) {
+      it = registry.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  topic = registry[key].lock();
+  if (!topic) {
+    topic = std::make_shared<IntraProcessTopic>();
+    registry[key] = topic;
+  }
+  return true;
+}
+
+bool
+IntraProcessTopic::is_local_reader(const DDS::InstanceHandle_t & reader_handle) const
+{
+  std::shared_ptr<const Endpoints> endpoints = get_endpoints();
+  for (const auto & receiver : endpoints->receivers) {
+    if (DDS_InstanceHandle_equals(&receiver->reader_handle, &reader_handle)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+IntraProcessTopic::is_local_writer(const DDS::InstanceHandle_t & writer_handle) const
+{
+  std::shared_ptr<const Endpoints> endpoints = get_endpoints();
+  for (const auto & local_writer_handle : endpoints->writer_handles) {
+    if (DDS_InstanceHandle_equals(&local_writer_handle, &writer_handle)) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,234 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INTRA_PROCESS_HPP_
+#define INTRA_PROCESS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "rmw/types.h"
+
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+
+// Comma separated list of DDS topic names (e.g. "rt/image,rt/points*") delivered in process.
+// Samples published to subscriptions of these topics within the same context are handed over
+// as a shared serialized buffer instead of going through Connext. Subscriptions with a keep all
+// history always receive through Connext, since the in process queue drops the oldest message.
+#define RMW_CONNEXT_INTRA_PROCESS_TOPICS_ENV_VAR "RMW_CONNEXT_INTRA_PROCESS_TOPICS"
+
+/// Serialized sample handed from a local publisher to a local subscription.
+struct IntraProcessMessage
+{
+  std::shared_ptr<const uint8_t> buffer;
+  size_t buffer_length;
+  DDS::InstanceHandle_t publication_handle;
+  // nanoseconds since the epoch, like the timestamps of samples received through Connext
+  int64_t source_timestamp;
+  int64_t reception_timestamp;
+  // counted by the publisher for the messages delivered in process
+  int64_t sequence_number;
+};
+
+/// Bounded lock-free multi-producer multi-consumer queue.
+/**
+ * Every cell carries a sequence number telling producers and consumers whether it is
+ * free or filled for the current lap, so that pushing and popping only needs one
+ * compare-and-swap on the respective position.
+ */
+class IntraProcessQueue
+{
+public:
+  /// Create a queue holding at most `depth` messages.
+  explicit IntraProcessQueue(size_t depth);
+
+  /// Push a message, dropping the oldest ones beyond the depth like a keep last history.
+  void
+  push(IntraProcessMessage && message);
+
+  bool
+  pop(IntraProcessMessage & message);
+
+  bool
+  empty() const;
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    IntraProcessMessage message;
+  };
+
+  bool
+  try_push(IntraProcessMessage & message);
+
+  std::unique_ptr<Cell[]> cells_;
+  // the cells are rounded up to a power of two, the depth is enforced separately
+  size_t mask_;
+  size_t depth_;
+  std::atomic<size_t> enqueue_position_;
+  std::atomic<size_t> dequeue_position_;
+};
+
+/// Queue of a subscription, shared with the publishers delivering to it.
+/**
+ * Publishers deliver to the receivers of a snapshot of the topic without locking, so a
+ * receiver outlives its subscription until no publisher holds such a snapshot anymore.
+ */
+struct IntraProcessReceiver
+{
+  IntraProcessReceiver(
+    DDS::DataReader * topic_reader,
+    const DDS::DataReaderQos & datareader_qos,
+    bool ignore_local_publications);
+
+  void
+  deliver(const IntraProcessMessage & message);
+
+  DDS::InstanceHandle_t reader_handle;
+  DDS::InstanceHandle_t participant_handle;
+  bool reliable;
+  bool ignore_local_publications;
+  IntraProcessQueue queue;
+  DDS::GuardCondition condition;
+};
+
+class IntraProcessTopic;
+
+/// Receiving end of the in process delivery of a subscription.
+class IntraProcessSubscription
+{
+public:
+  IntraProcessSubscription(
+    std::shared_ptr<IntraProcessTopic> topic,
+    DDS::DataReader * topic_reader,
+    const DDS::DataReaderQos & datareader_qos,
+    bool ignore_local_publications);
+
+  ~IntraProcessSubscription();
+
+  /// Take the next message delivered in process, if any.
+  bool
+  take(IntraProcessMessage & message);
+
+  /// Check if a sample received through Connext has already been delivered in process.
+  bool
+  is_intra_process_publication(const DDS::InstanceHandle_t & publication_handle) const;
+
+  DDS::GuardCondition *
+  get_condition();
+
+private:
+  std::shared_ptr<IntraProcessTopic> topic_;
+  std::shared_ptr<IntraProcessReceiver> receiver_;
+};
+
+/// Sending end of the in process delivery of a publisher.
+class IntraProcessPublisher
+{
+public:
+  IntraProcessPublisher(
+    std::shared_ptr<IntraProcessTopic> topic,
+    DDS::DataWriter * topic_writer,
+    const DDS::DataWriterQos & datawriter_qos);
+
+  ~IntraProcessPublisher();
+
+  /// Check if any local subscription would receive a published message.
+  bool
+  has_local_subscriptions() const;
+
+  /// Deliver a serialized message to all matching local subscriptions.
+  void
+  publish(std::shared_ptr<const uint8_t> buffer, size_t buffer_length);
+
+  /// Check if the datawriter is matched with any subscription outside of the fast path.
+  /**
+   * Connext is only asked for the matched subscriptions after the matches or the local
+   * subscriptions changed.
+   *
+   * \param match_changes number of publication matched status changes of the datawriter
+   */
+  bool
+  has_remote_subscriptions(uint64_t match_changes);
+
+private:
+  std::shared_ptr<IntraProcessTopic> topic_;
+  DDS::DataWriter * topic_writer_;
+  DDS::InstanceHandle_t writer_handle_;
+  DDS::InstanceHandle_t participant_handle_;
+  bool reliable_;
+  std::atomic<int64_t> sequence_number_;
+  std::atomic<uint64_t> checked_match_changes_;
+  std::atomic<uint64_t> checked_topic_changes_;
+  std::atomic<bool> has_remote_subscriptions_;
+};
+
+/// Local publishers and subscriptions sharing a topic name and type within a context.
+/**
+ * The endpoints are kept as an immutable snapshot, which is copied and replaced when they
+ * change, so that publishing and taking read them without locking.
+ */
+class IntraProcessTopic
+{
+public:
+  /// Get the entry for a topic, or nothing if in process delivery is disabled for it.
+  /**
+   * \return false if the configuration could not be read, the error is set
+   */
+  static bool
+  get(
+    const rmw_context_t * context,
+    DDS::DomainParticipant * participant,
+    const char * topic_name,
+    const std::string & type_name,
+    std::shared_ptr<IntraProcessTopic> & topic);
+
+  IntraProcessTopic();
+
+private:
+  friend class IntraProcessPublisher;
+  friend class IntraProcessSubscription;
+
+  struct Endpoints
+  {
+    std::vector<std::shared_ptr<IntraProcessReceiver>> receivers;
+    std::vector<DDS::InstanceHandle_t> writer_handles;
+  };
+
+  std::shared_ptr<const Endpoints>
+  get_endpoints() const;
+
+  template<typename UpdateT>
+  void
+  update_endpoints(UpdateT update);
+
+  bool
+  is_local_reader(const DDS::InstanceHandle_t & reader_handle) const;
+
+  bool
+  is_local_writer(const DDS::InstanceHandle_t & writer_handle) const;
+
+  // serializes the updates of the endpoints, which are read without it
+  std::mutex mutex_;
+  std::shared_ptr<const Endpoints> endpoints_;
+  std::atomic<uint64_t> changes_;
+};
+
+#endif  // INTRA_PROCESS_HPP_
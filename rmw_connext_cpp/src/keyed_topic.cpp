@@ -0,0 +1,98 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <mutex>
+#include <string>
+
+#include "rmw/error_handling.h"
+
+#include "rmw_connext_shared_cpp/environment.hpp"
+
+#include "keyed_topic.hpp"
+
+// include patched generated code from the build folder
+#include "connext_static_serialized_dataSupport.h"
+
+bool
+_register_serialized_data_type(
+  ConnextNodeInfo * node_info,
+  const char * topic_name,
+  const std::string & type_name,
+  DDS::TypeCode * type_code,
+  bool & keyed)
+{
+  std::string keyed_topics;
+  if (!get_env_string(RMW_CONNEXT_KEYED_TOPICS_ENV_VAR, keyed_topics)) {
+    return false;
+  }
+  keyed = topic_name_matches(keyed_topics, topic_name);
+
+  // Connext keeps the type plugin of the first registration of a type name, which decides
+  // whether the samples of all topics of the type have an instance key
+  std::lock_guard<std::mutex> lock(node_info->keyed_types_mutex);
+  auto registered = node_info->keyed_types.find(type_name);
+  if (registered != node_info->keyed_types.end()) {
+    if (registered->second.keyed != keyed) {
+      std::string error_msg = "type '" + type_name + "' of topic '" + topic_name +
+        "' is already used " + (registered->second.keyed ? "with" : "without") +
+        " an instance key by another topic of the node, check " +
+        RMW_CONNEXT_KEYED_TOPICS_ENV_VAR;
+      RMW_SET_ERROR_MSG(error_msg.c_str());
+      return false;
+    }
+  }
+
+  // This is a non-standard RTI Connext function
+  // It allows to register an external type to a static data writer
+  // In this case, we register the custom message type to a data writer,
+  // which only publishes DDS_Octets
+  // The purpose of this is to send only raw data DDS_Octets over the wire,
+  // advertise the topic however with a type of the message, e.g. std_msgs::msg::dds_::String
+  DDS::ReturnCode_t status;
+  if (keyed) {
+    status = ConnextStaticSerializedDataSupport_register_external_keyed_type(
+      node_info->participant, type_name.c_str(), type_code);
+  } else {
+    status = ConnextStaticSerializedDataSupport_register_external_type(
+      node_info->participant, type_name.c_str(), type_code);
+  }
+  if (status != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to register external type");
+    return false;
+  }
+  ConnextRegisteredType & registered_type = node_info->keyed_types[type_name];
+  registered_type.keyed = keyed;
+  ++registered_type.endpoint_count;
+  return true;
+}
+
+void
+_unregister_serialized_data_type(ConnextNodeInfo * node_info, const std::string & type_name)
+{
+  std::lock_guard<std::mutex> lock(node_info->keyed_types_mutex);
+  auto registered = node_info->keyed_types.find(type_name);
+  if (registered == node_info->keyed_types.end() || registered->second.endpoint_count == 0) {
+    return;
+  }
+  if (--registered->second.endpoint_count > 0) {
+    return;
+  }
+  // Connext refuses while topics of the type exist, the record is kept as long as Connext
+  // keeps the registration, which a later registration of the type would reuse
+  if (ConnextStaticSerializedDataTypeSupport::unregister_type(
+      node_info->participant, type_name.c_str()) == DDS::RETCODE_OK)
+  {
+    node_info->keyed_types.erase(registered);
+  }
+}
@@ -0,0 +1,51 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef KEYED_TOPIC_HPP_
+#define KEYED_TOPIC_HPP_
+
+#include <string>
+
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+#include "rmw_connext_shared_cpp/types.hpp"
+
+// Comma separated list of DDS topic names (e.g. "rt/fleet/*") published with instance keys.
+// Samples of these topics carry the key given to rmw_connext_cpp::publish_with_key() in the
+// key_hash of the serialized data, so that history, ownership and liveliness apply per key.
+// A topic has to be keyed on all nodes publishing or subscribing it, and the topics of a node
+// using the same message type have to be all keyed or all not keyed.
+#define RMW_CONNEXT_KEYED_TOPICS_ENV_VAR "RMW_CONNEXT_KEYED_TOPICS"
+
+/// Register the serialized data type of a topic with the participant of the node.
+/**
+ * \param[out] keyed true if the type has been registered with an instance key
+ * \return false if the type could not be registered or is already registered by the node
+ *   with the other key kind, the error is set
+ */
+bool
+_register_serialized_data_type(
+  ConnextNodeInfo * node_info,
+  const char * topic_name,
+  const std::string & type_name,
+  DDS::TypeCode * type_code,
+  bool & keyed);
+
+/// Release the registration of the serialized data type by an endpoint of the node.
+/**
+ * The type is unregistered from the participant with the last endpoint using it.
+ */
+void
+_unregister_serialized_data_type(ConnextNodeInfo * node_info, const std::string & type_name);
+
+#endif  // KEYED_TOPIC_HPP_
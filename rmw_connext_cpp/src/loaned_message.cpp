@@ -0,0 +1,337 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "rmw/allocators.h"
+#include "rmw/error_handling.h"
+#include "rmw/impl/cpp/macros.hpp"
+#include "rmw/rmw.h"
+
+#include "rmw_connext_cpp/loaned_message.hpp"
+
+#include "rmw_connext_shared_cpp/message_info.hpp"
+#include "rmw_connext_shared_cpp/types.hpp"
+
+#include "rmw_connext_cpp/connext_static_publisher_info.hpp"
+#include "rmw_connext_cpp/connext_static_subscriber_info.hpp"
+#include "rmw_connext_cpp/identifier.hpp"
+
+#include "ignore_sample.hpp"
+#include "intra_process.hpp"
+#include "publisher_loan_pool.hpp"
+#include "subscription_loan_pool.hpp"
+
+static ConnextStaticPublisherInfo *
+get_publisher_info(const rmw_publisher_t * publisher)
+{
+  auto publisher_info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!publisher_info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return nullptr;
+  }
+  return publisher_info;
+}
+
+static ConnextStaticSubscriberInfo *
+get_subscriber_info(const rmw_subscription_t * subscription)
+{
+  auto subscriber_info = static_cast<ConnextStaticSubscriberInfo *>(subscription->data);
+  if (!subscriber_info) {
+    RMW_SET_ERROR_MSG("subscriber info handle is null");
+    return nullptr;
+  }
+  return subscriber_info;
+}
+
+// Take a sample from the datareader into a loan, false if there is none to pass on.
+static bool
+take_into_loan(
+  ConnextStaticSubscriberInfo * subscriber_info,
+  SubscriptionLoanPool * loan_pool,
+  SubscriptionLoanPool::Loan * loan,
+  bool * taken)
+{
+  IntraProcessSubscription * intra_process = subscriber_info->intra_process_;
+  if (intra_process && intra_process->take(loan->intra_process_message)) {
+    loan->buffer = loan->intra_process_message.buffer.get();
+    *taken = true;
+    return true;
+  }
+
+  DDS::ReturnCode_t status = loan_pool->get_data_reader()->take(
+    loan->data_seq,
+    loan->info_seq,
+    1,
+    DDS::ANY_SAMPLE_STATE,
+    DDS::ANY_VIEW_STATE,
+    DDS::ANY_INSTANCE_STATE);
+  if (status == DDS::RETCODE_NO_DATA) {
+    *taken = false;
+    return true;
+  }
+  if (status != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("take failed");
+    return false;
+  }
+  if (_ignore_sample(
+      subscriber_info->topic_reader_, loan->info_seq[0],
+      subscriber_info->ignore_local_publications, intra_process))
+  {
+    *taken = false;
+    return true;
+  }
+  loan->buffer = loan->data_seq[0].serialized_data.get_contiguous_buffer();
+  *taken = true;
+  return true;
+}
+
+namespace rmw_connext_cpp
+{
+
+rmw_ret_t
+init_publisher_loans(const rmw_publisher_t * publisher, size_t slot_count, size_t slot_size)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+  if (slot_count == 0 || slot_size == 0) {
+    RMW_SET_ERROR_MSG("slot count and size must not be zero");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  ConnextStaticPublisherInfo * publisher_info = get_publisher_info(publisher);
+  if (!publisher_info) {
+    return RMW_RET_ERROR;
+  }
+  if (publisher_info->loan_pool_) {
+    RMW_SET_ERROR_MSG("loaned message slots are already initialized");
+    return RMW_RET_ERROR;
+  }
+
+  void * buf = rmw_allocate(sizeof(PublisherLoanPool));
+  if (!buf) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for loaned message slots");
+    return RMW_RET_BAD_ALLOC;
+  }
+  RMW_TRY_PLACEMENT_NEW(
+    publisher_info->loan_pool_, buf,
+    rmw_free(buf); return RMW_RET_BAD_ALLOC,
+    PublisherLoanPool, slot_count, slot_size)
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+borrow_loaned_message(
+  const rmw_publisher_t * publisher,
+  rmw_serialized_message_t * loaned_message)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+
+  ConnextStaticPublisherInfo * publisher_info = get_publisher_info(publisher);
+  if (!publisher_info) {
+    return RMW_RET_ERROR;
+  }
+  PublisherLoanPool * loan_pool = publisher_info->loan_pool_;
+  if (!loan_pool) {
+    RMW_SET_ERROR_MSG("loaned message slots have not been initialized");
+    return RMW_RET_ERROR;
+  }
+
+  uint8_t * slot = loan_pool->borrow();
+  if (!slot) {
+    RMW_SET_ERROR_MSG("all loaned message slots are in use");
+    return RMW_RET_ERROR;
+  }
+  *loaned_message = rmw_get_zero_initialized_serialized_message();
+  loaned_message->buffer = slot;
+  loaned_message->buffer_capacity = loan_pool->slot_size();
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+publish_loaned_message(
+  const rmw_publisher_t * publisher,
+  rmw_serialized_message_t * loaned_message)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+  if (loaned_message->buffer_length > loaned_message->buffer_capacity) {
+    RMW_SET_ERROR_MSG("loaned message length exceeds the slot size");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  // the serialized message is written as is, only the encapsulation needs to be valid
+  rmw_ret_t ret = rmw_publish_serialized_message(publisher, loaned_message, nullptr);
+  rmw_ret_t return_ret = return_loaned_message(publisher, loaned_message);
+  return ret != RMW_RET_OK ? ret : return_ret;
+}
+
+rmw_ret_t
+return_loaned_message(
+  const rmw_publisher_t * publisher,
+  rmw_serialized_message_t * loaned_message)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+
+  ConnextStaticPublisherInfo * publisher_info = get_publisher_info(publisher);
+  if (!publisher_info) {
+    return RMW_RET_ERROR;
+  }
+  PublisherLoanPool * loan_pool = publisher_info->loan_pool_;
+  if (!loan_pool || !loan_pool->release(loaned_message->buffer)) {
+    RMW_SET_ERROR_MSG("message has not been loaned from this publisher");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  *loaned_message = rmw_get_zero_initialized_serialized_message();
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+init_subscription_loans(const rmw_subscription_t * subscription, size_t max_loans)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    subscription handle,
+    subscription->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+  if (max_loans == 0) {
+    RMW_SET_ERROR_MSG("maximum number of loans must not be zero");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  ConnextStaticSubscriberInfo * subscriber_info = get_subscriber_info(subscription);
+  if (!subscriber_info) {
+    return RMW_RET_ERROR;
+  }
+  if (subscriber_info->loan_pool_) {
+    RMW_SET_ERROR_MSG("loaned messages are already initialized");
+    return RMW_RET_ERROR;
+  }
+  ConnextStaticSerializedDataDataReader * data_reader =
+    ConnextStaticSerializedDataDataReader::narrow(subscriber_info->topic_reader_);
+  if (!data_reader) {
+    RMW_SET_ERROR_MSG("failed to narrow data reader");
+    return RMW_RET_ERROR;
+  }
+
+  void * buf = rmw_allocate(sizeof(SubscriptionLoanPool));
+  if (!buf) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for loaned messages");
+    return RMW_RET_BAD_ALLOC;
+  }
+  RMW_TRY_PLACEMENT_NEW(
+    subscriber_info->loan_pool_, buf,
+    rmw_free(buf); return RMW_RET_BAD_ALLOC,
+    SubscriptionLoanPool, data_reader, max_loans)
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+take_loaned_message(
+  const rmw_subscription_t * subscription,
+  rmw_serialized_message_t * loaned_message,
+  bool * taken,
+  rmw_message_info_t * message_info)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    subscription handle,
+    subscription->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+
+  ConnextStaticSubscriberInfo * subscriber_info = get_subscriber_info(subscription);
+  if (!subscriber_info) {
+    return RMW_RET_ERROR;
+  }
+  SubscriptionLoanPool * loan_pool = subscriber_info->loan_pool_;
+  if (!loan_pool) {
+    RMW_SET_ERROR_MSG("loaned messages have not been initialized");
+    return RMW_RET_ERROR;
+  }
+
+  SubscriptionLoanPool::Loan * loan = loan_pool->acquire();
+  if (!loan) {
+    RMW_SET_ERROR_MSG("all loaned messages are outstanding");
+    return RMW_RET_ERROR;
+  }
+  if (!take_into_loan(subscriber_info, loan_pool, loan, taken)) {
+    loan_pool->release(loan);
+    return RMW_RET_ERROR;
+  }
+  if (!*taken) {
+    loan_pool->release(loan);
+    return RMW_RET_OK;
+  }
+
+  *loaned_message = rmw_get_zero_initialized_serialized_message();
+  loaned_message->buffer = const_cast<uint8_t *>(loan->buffer);
+  if (loan->intra_process_message.buffer) {
+    loaned_message->buffer_length = loan->intra_process_message.buffer_length;
+  } else {
+    loaned_message->buffer_length = loan->data_seq[0].serialized_data.length();
+  }
+  loaned_message->buffer_capacity = loaned_message->buffer_length;
+
+  if (message_info) {
+    const DDS::InstanceHandle_t & publication_handle = loan->intra_process_message.buffer ?
+      loan->intra_process_message.publication_handle : loan->info_seq[0].publication_handle;
+    set_publisher_gid(rti_connext_identifier, publication_handle, message_info->publisher_gid);
+  }
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+return_loaned_message_from_subscription(
+  const rmw_subscription_t * subscription,
+  rmw_serialized_message_t * loaned_message)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    subscription handle,
+    subscription->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+
+  ConnextStaticSubscriberInfo * subscriber_info = get_subscriber_info(subscription);
+  if (!subscriber_info) {
+    return RMW_RET_ERROR;
+  }
+  SubscriptionLoanPool * loan_pool = subscriber_info->loan_pool_;
+  if (!loan_pool || !loan_pool->release(loaned_message->buffer)) {
+    RMW_SET_ERROR_MSG("message has not been loaned from this subscription");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  *loaned_message = rmw_get_zero_initialized_serialized_message();
+  return RMW_RET_OK;
+}
+
+}  // namespace rmw_connext_cpp
@@ -0,0 +1,75 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <mutex>
+
+#include "publisher_loan_pool.hpp"
+
+PublisherLoanPool::PublisherLoanPool(size_t slot_count, size_t slot_size)
+: slot_count_(slot_count),
+  slot_size_(slot_size),
+  // keep every slot aligned for the largest primitive type
+  slot_stride_((slot_size + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t))
+{
+  memory_.reset(new uint64_t[slot_count_ * slot_stride_ / sizeof(uint64_t)]);
+  loaned_.resize(slot_count_, false);
+  free_slots_.reserve(slot_count_);
+  for (size_t i = slot_count_; i > 0; --i) {
+    free_slots_.push_back(begin() + (i - 1) * slot_stride_);
+  }
+}
+
+uint8_t *
+PublisherLoanPool::borrow()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_slots_.empty()) {
+    return nullptr;
+  }
+  uint8_t * slot = free_slots_.back();
+  free_slots_.pop_back();
+  loaned_[static_cast<size_t>(slot - begin()) / slot_stride_] = true;
+  return slot;
+}
+
+bool
+PublisherLoanPool::release(const uint8_t * slot)
+{
+  if (slot < begin() || slot >= begin() + slot_count_ * slot_stride_ ||
+    static_cast<size_t>(slot - begin()) % slot_stride_ != 0)
+  {
+    return false;
+  }
+  size_t index = static_cast<size_t>(slot - begin()) / slot_stride_;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!loaned_[index]) {
+    return false;
+  }
+  loaned_[index] = false;
+  // the free list was reserved for all slots, this does not allocate
+  free_slots_.push_back(begin() + index * slot_stride_);
+  return true;
+}
+
+size_t
+PublisherLoanPool::slot_size() const
+{
+  return slot_size_;
+}
+
+uint8_t *
+PublisherLoanPool::begin() const
+{
+  return reinterpret_cast<uint8_t *>(memory_.get());
+}
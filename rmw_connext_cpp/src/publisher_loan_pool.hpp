@@ -0,0 +1,54 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PUBLISHER_LOAN_POOL_HPP_
+#define PUBLISHER_LOAN_POOL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// Fixed set of preallocated buffers which are loaned to the application.
+class PublisherLoanPool
+{
+public:
+  PublisherLoanPool(size_t slot_count, size_t slot_size);
+
+  /// Get a free slot, or `nullptr` if all of them are loaned.
+  uint8_t *
+  borrow();
+
+  /// Give a slot back, false if it does not belong to this pool.
+  bool
+  release(const uint8_t * slot);
+
+  size_t
+  slot_size() const;
+
+private:
+  uint8_t *
+  begin() const;
+
+  std::mutex mutex_;
+  std::unique_ptr<uint64_t[]> memory_;
+  std::vector<uint8_t *> free_slots_;
+  std::vector<bool> loaned_;
+  size_t slot_count_;
+  size_t slot_size_;
+  size_t slot_stride_;
+};
+
+#endif  // PUBLISHER_LOAN_POOL_HPP_
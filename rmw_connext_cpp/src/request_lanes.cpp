@@ -0,0 +1,190 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rmw/error_handling.h"
+#include "rmw/impl/cpp/macros.hpp"
+#include "rmw/rmw.h"
+
+#include "rmw_connext_cpp/request_lanes.hpp"
+
+#include "rmw_connext_cpp/connext_static_client_info.hpp"
+#include "rmw_connext_cpp/connext_static_service_info.hpp"
+#include "rmw_connext_cpp/identifier.hpp"
+
+#include "serialized_service.hpp"
+
+// Delete the read conditions and datareaders of request lanes.
+static bool
+delete_lanes(
+  DDS::DomainParticipant * participant,
+  const std::vector<DDS::DataReader *> & datareaders,
+  const std::vector<DDS::ReadCondition *> & read_conditions)
+{
+  bool result = true;
+  for (size_t i = 0; i < datareaders.size(); ++i) {
+    if (i < read_conditions.size() &&
+      datareaders[i]->delete_readcondition(read_conditions[i]) != DDS::RETCODE_OK)
+    {
+      RMW_SET_ERROR_MSG("failed to delete readcondition");
+      result = false;
+      continue;
+    }
+    if (!_delete_serialized_entities(participant, datareaders[i], nullptr)) {
+      result = false;
+    }
+  }
+  return result;
+}
+
+bool
+_delete_request_lanes(ConnextStaticServiceInfo * service_info)
+{
+  if (service_info->lane_datareaders_.empty()) {
+    return true;
+  }
+  DDS::DomainParticipant * participant =
+    service_info->request_datareader_->get_subscriber()->get_participant();
+  bool result = delete_lanes(
+    participant, service_info->lane_datareaders_, service_info->lane_conditions_);
+  service_info->lane_datareaders_.clear();
+  service_info->lane_conditions_.clear();
+  service_info->default_lane_ = 0;
+  return result;
+}
+
+namespace rmw_connext_cpp
+{
+
+rmw_ret_t
+init_request_lanes(const rmw_service_t * service, const char * const * lanes, size_t lane_count)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(service, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(lanes, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    service handle,
+    service->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+
+  auto service_info = static_cast<ConnextStaticServiceInfo *>(service->data);
+  if (!service_info) {
+    RMW_SET_ERROR_MSG("service info handle is null");
+    return RMW_RET_ERROR;
+  }
+  if (!service_info->response_datawriter_) {
+    RMW_SET_ERROR_MSG("service was not created for serialized requests");
+    return RMW_RET_ERROR;
+  }
+  if (!service_info->lane_datareaders_.empty()) {
+    RMW_SET_ERROR_MSG("request lanes are already initialized");
+    return RMW_RET_ERROR;
+  }
+
+  // the default lane is the last one unless it is listed
+  size_t default_lane = lane_count;
+  std::set<std::string> names;
+  for (size_t i = 0; i < lane_count; ++i) {
+    RMW_CHECK_ARGUMENT_FOR_NULL(lanes[i], RMW_RET_INVALID_ARGUMENT);
+    if (!names.insert(lanes[i]).second) {
+      RMW_SET_ERROR_MSG("request lane is listed twice");
+      return RMW_RET_INVALID_ARGUMENT;
+    }
+    if (!*lanes[i]) {
+      default_lane = i;
+    }
+  }
+
+  DDS::DomainParticipant * participant =
+    service_info->request_datareader_->get_subscriber()->get_participant();
+  std::vector<DDS::DataReader *> datareaders;
+  std::vector<DDS::ReadCondition *> read_conditions;
+  for (size_t i = 0; i < lane_count; ++i) {
+    if (i == default_lane) {
+      continue;
+    }
+    DDS::DataReader * datareader = _create_serialized_lane_datareader(
+      participant, service_info->request_datareader_, lanes[i]);
+    if (!datareader) {
+      delete_lanes(participant, datareaders, read_conditions);
+      return RMW_RET_ERROR;
+    }
+    datareaders.push_back(datareader);
+    DDS::ReadCondition * read_condition = datareader->create_readcondition(
+      DDS::ANY_SAMPLE_STATE, DDS::ANY_VIEW_STATE, DDS::ANY_INSTANCE_STATE);
+    if (!read_condition) {
+      RMW_SET_ERROR_MSG("failed to create read condition");
+      delete_lanes(participant, datareaders, read_conditions);
+      return RMW_RET_ERROR;
+    }
+    read_conditions.push_back(read_condition);
+  }
+
+  service_info->lane_datareaders_ = std::move(datareaders);
+  service_info->lane_conditions_ = std::move(read_conditions);
+  service_info->default_lane_ = default_lane;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+set_request_lane(const rmw_client_t * client, const char * lane)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(lane, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    client handle,
+    client->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+
+  auto client_info = static_cast<ConnextStaticClientInfo *>(client->data);
+  if (!client_info) {
+    RMW_SET_ERROR_MSG("client info handle is null");
+    return RMW_RET_ERROR;
+  }
+  if (!client_info->request_datawriter_) {
+    RMW_SET_ERROR_MSG("client was not created for serialized requests");
+    return RMW_RET_ERROR;
+  }
+  if (client_info->shared_requester_) {
+    RMW_SET_ERROR_MSG("client shares its request datawriter");
+    return RMW_RET_ERROR;
+  }
+
+  DDS::Publisher * dds_publisher = client_info->request_datawriter_->get_publisher();
+  DDS::PublisherQos publisher_qos;
+  if (dds_publisher->get_qos(publisher_qos) != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to get publisher qos");
+    return RMW_RET_ERROR;
+  }
+  if (*lane) {
+    if (!publisher_qos.partition.name.ensure_length(1, 1)) {
+      RMW_SET_ERROR_MSG("failed to set publisher partition");
+      return RMW_RET_ERROR;
+    }
+    DDS::String_free(publisher_qos.partition.name[0]);
+    publisher_qos.partition.name[0] = DDS::String_dup(lane);
+  } else {
+    publisher_qos.partition.name.length(0);
+  }
+  if (dds_publisher->set_qos(publisher_qos) != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to set publisher qos");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
+
+}  // namespace rmw_connext_cpp
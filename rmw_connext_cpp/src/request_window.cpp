@@ -0,0 +1,100 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+
+#include "rmw/allocators.h"
+#include "rmw/error_handling.h"
+#include "rmw/impl/cpp/macros.hpp"
+#include "rmw/rmw.h"
+
+#include "rmw_connext_cpp/request_window.hpp"
+
+#include "rmw_connext_cpp/connext_static_client_info.hpp"
+#include "rmw_connext_cpp/identifier.hpp"
+
+#include "in_flight_requests.hpp"
+
+static ConnextStaticClientInfo *
+get_client_info(const rmw_client_t * client)
+{
+  auto client_info = static_cast<ConnextStaticClientInfo *>(client->data);
+  if (!client_info) {
+    RMW_SET_ERROR_MSG("client info handle is null");
+    return nullptr;
+  }
+  return client_info;
+}
+
+namespace rmw_connext_cpp
+{
+
+rmw_ret_t
+init_request_window(const rmw_client_t * client, size_t max_in_flight, rmw_time_t timeout)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    client handle,
+    client->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+
+  ConnextStaticClientInfo * client_info = get_client_info(client);
+  if (!client_info) {
+    return RMW_RET_ERROR;
+  }
+  if (client_info->in_flight_) {
+    RMW_SET_ERROR_MSG("request window is already initialized");
+    return RMW_RET_ERROR;
+  }
+
+  int64_t timeout_ns = static_cast<int64_t>(timeout.sec) * 1000000000 +
+    static_cast<int64_t>(timeout.nsec);
+  void * buf = rmw_allocate(sizeof(InFlightRequests));
+  if (!buf) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for request window");
+    return RMW_RET_BAD_ALLOC;
+  }
+  RMW_TRY_PLACEMENT_NEW(
+    client_info->in_flight_, buf,
+    rmw_free(buf); return RMW_RET_BAD_ALLOC,
+    InFlightRequests, max_in_flight, timeout_ns)
+  client_info->expiry_condition_ = client_info->in_flight_->get_condition();
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+take_expired_request(const rmw_client_t * client, int64_t * sequence_id, bool * taken)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(sequence_id, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    client handle,
+    client->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+
+  ConnextStaticClientInfo * client_info = get_client_info(client);
+  if (!client_info) {
+    return RMW_RET_ERROR;
+  }
+  InFlightRequests * in_flight = client_info->in_flight_;
+  if (!in_flight) {
+    RMW_SET_ERROR_MSG("request window has not been initialized");
+    return RMW_RET_ERROR;
+  }
+  *taken = in_flight->take_expired(*sequence_id);
+  return RMW_RET_OK;
+}
+
+}  // namespace rmw_connext_cpp
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
 #include <string>
 
 #include "rmw/allocators.h"
@@ -24,7 +25,11 @@
 
 #include "rmw_connext_cpp/connext_static_client_info.hpp"
 #include "rmw_connext_cpp/identifier.hpp"
+#include "rmw_connext_cpp/serialized_service.hpp"
+#include "in_flight_requests.hpp"
 #include "process_topic_and_service_names.hpp"
+#include "serialized_service.hpp"
+#include "shared_requester.hpp"
 #include "type_support_common.hpp"
 
 // Uncomment this to get extra console output about discovery.
@@ -34,12 +39,13 @@
 
 extern "C"
 {
-rmw_client_t *
-rmw_create_client(
+static rmw_client_t *
+_create_client(
   const rmw_node_t * node,
   const rosidl_service_type_support_t * type_supports,
   const char * service_name,
-  const rmw_qos_profile_t * qos_profile)
+  const rmw_qos_profile_t * qos_profile,
+  bool serialized)
 {
   if (!node) {
     RMW_SET_ERROR_MSG("node handle is null");
@@ -74,6 +80,18 @@ rmw_create_client(
     RMW_SET_ERROR_MSG("callbacks handle is null");
     return NULL;
   }
+
+  // Connext keeps the first type registered under a name, so a node can not use the types
+  // of a service both typed and serialized
+  if (serialized) {
+    if (!_register_serialized_service_types(node_info, callbacks)) {
+      // error string was set within the function
+      return NULL;
+    }
+  } else if (!_check_typed_service_types(node_info, callbacks)) {
+    // error string was set within the function
+    return NULL;
+  }
   // Past this point, a failure results in unrolling code in the goto fail block.
   DDS::SubscriberQos subscriber_qos;
   DDS::ReturnCode_t status;
@@ -88,6 +106,11 @@ rmw_create_client(
   void * requester = nullptr;
   void * buf = nullptr;
   ConnextStaticClientInfo * client_info = nullptr;
+  void * listener_buf = nullptr;
+  ConnextClientListener * client_listener = nullptr;
+  std::shared_ptr<SharedRequester> shared_requester;
+  void * shared_client_buf = nullptr;
+  SharedRequesterClient * shared_client = nullptr;
   rmw_client_t * client = nullptr;
   std::string mangled_name = "";
 
@@ -102,16 +125,6 @@ rmw_create_client(
     goto fail;
   }
 
-  if (!get_datareader_qos(participant, *qos_profile, datareader_qos)) {
-    // error string was set within the function
-    goto fail;
-  }
-
-  if (!get_datawriter_qos(participant, *qos_profile, datawriter_qos)) {
-    // error string was set within the function
-    goto fail;
-  }
-
   // allocating memory for request topic and response topic strings
   if (!_process_service_name(
       service_name,
@@ -122,18 +135,48 @@ rmw_create_client(
     goto fail;
   }
 
-  requester = callbacks->create_requester(
-    participant, request_topic_str, response_topic_str,
-    &datareader_qos, &datawriter_qos,
-    reinterpret_cast<void **>(&response_datareader),
-    reinterpret_cast<void **>(&request_datawriter),
-    &rmw_allocate);
+  if (!get_datareader_qos(participant, *qos_profile, response_topic_str, datareader_qos)) {
+    // error string was set within the function
+    goto fail;
+  }
+
+  if (!get_datawriter_qos(participant, *qos_profile, request_topic_str, datawriter_qos)) {
+    // error string was set within the function
+    goto fail;
+  }
+
+  if (serialized) {
+    if (!SharedRequester::get(
+        node_info, callbacks, request_topic_str, response_topic_str,
+        datareader_qos, datawriter_qos, shared_requester))
+    {
+      // error string was set within the function
+      goto fail;
+    }
+    if (shared_requester) {
+      response_datareader = shared_requester->get_response_datareader();
+      request_datawriter = shared_requester->get_request_datawriter();
+    } else if (!_create_serialized_requester(
+        participant, callbacks, request_topic_str, response_topic_str,
+        datareader_qos, datawriter_qos, &response_datareader, &request_datawriter))
+    {
+      // error string was set within the function
+      goto fail;
+    }
+  } else {
+    requester = callbacks->create_requester(
+      participant, request_topic_str, response_topic_str,
+      &datareader_qos, &datawriter_qos,
+      reinterpret_cast<void **>(&response_datareader),
+      reinterpret_cast<void **>(&request_datawriter),
+      &rmw_allocate);
+  }
   DDS::String_free(request_topic_str);
   request_topic_str = nullptr;
   DDS::String_free(response_topic_str);
   response_topic_str = nullptr;
 
-  if (!requester) {
+  if (!serialized && !requester) {
     RMW_SET_ERROR_MSG("failed to create requester");
     goto fail;
   }
@@ -185,6 +228,50 @@ rmw_create_client(
   client_info->callbacks_ = callbacks;
   client_info->response_datareader_ = response_datareader;
   client_info->read_condition_ = read_condition;
+  if (serialized) {
+    client_info->request_datawriter_ = request_datawriter;
+  }
+
+  if (shared_requester) {
+    // the shared requester keeps the matches and is registered with the graph already
+    shared_client_buf = rmw_allocate(sizeof(SharedRequesterClient));
+    if (!shared_client_buf) {
+      RMW_SET_ERROR_MSG("failed to allocate memory for shared requester client");
+      goto fail;
+    }
+    RMW_TRY_PLACEMENT_NEW(
+      shared_client, shared_client_buf, goto fail, SharedRequesterClient,
+      shared_requester, client_info)
+    shared_client_buf = nullptr;  // Only free the shared_client pointer.
+    client_info->shared_requester_ = shared_client;
+    client_info->reply_condition_ = shared_client->get_condition();
+  }
+
+  // track the matches of the service server instead of querying them on every availability check
+  if (!shared_client) {
+    listener_buf = rmw_allocate(sizeof(ConnextClientListener));
+    if (!listener_buf) {
+      RMW_SET_ERROR_MSG("failed to allocate memory for client listener");
+      goto fail;
+    }
+    RMW_TRY_PLACEMENT_NEW(
+      client_listener, listener_buf, goto fail, ConnextClientListener,
+      client_info, node_info->graph_guard_condition)
+    listener_buf = nullptr;  // Only free the client_listener pointer.
+    client_info->listener_ = client_listener;
+    if (request_datawriter->set_listener(
+        client_listener, DDS::PUBLICATION_MATCHED_STATUS) != DDS::RETCODE_OK ||
+      response_datareader->set_listener(
+        client_listener, DDS::SUBSCRIPTION_MATCHED_STATUS) != DDS::RETCODE_OK)
+    {
+      RMW_SET_ERROR_MSG("failed to set client listener");
+      goto fail;
+    }
+    if (!client_listener->update_matched_counts(request_datawriter, response_datareader)) {
+      // error string was set within the function
+      goto fail;
+    }
+  }
 
   client->implementation_identifier = rti_connext_identifier;
   client->data = client_info;
@@ -195,25 +282,27 @@ rmw_create_client(
   }
   memcpy(const_cast<char *>(client->service_name), service_name, strlen(service_name) + 1);
 
-  mangled_name =
-    response_datareader->get_topicdescription()->get_name();
-  node_info->subscriber_listener->add_information(
-    node_info->participant->get_instance_handle(),
-    response_datareader->get_instance_handle(),
-    mangled_name,
-    response_datareader->get_topicdescription()->get_type_name(),
-    EntityType::Subscriber);
-  node_info->subscriber_listener->trigger_graph_guard_condition();
-
-  mangled_name =
-    request_datawriter->get_topic()->get_name();
-  node_info->publisher_listener->add_information(
-    node_info->participant->get_instance_handle(),
-    request_datawriter->get_instance_handle(),
-    mangled_name,
-    request_datawriter->get_topic()->get_type_name(),
-    EntityType::Publisher);
-  node_info->publisher_listener->trigger_graph_guard_condition();
+  if (!shared_client) {
+    mangled_name =
+      _get_reader_topic_name(response_datareader);
+    node_info->subscriber_listener->add_information(
+      node_info->participant->get_instance_handle(),
+      response_datareader->get_instance_handle(),
+      mangled_name,
+      response_datareader->get_topicdescription()->get_type_name(),
+      EntityType::Subscriber);
+    node_info->subscriber_listener->trigger_graph_guard_condition();
+
+    mangled_name =
+      request_datawriter->get_topic()->get_name();
+    node_info->publisher_listener->add_information(
+      node_info->participant->get_instance_handle(),
+      request_datawriter->get_instance_handle(),
+      mangled_name,
+      request_datawriter->get_topic()->get_type_name(),
+      EntityType::Publisher);
+    node_info->publisher_listener->trigger_graph_guard_condition();
+  }
 
 // TODO(karsten1987): replace this block with logging macros
 #ifdef DISCOVERY_DEBUG_LOGGING
@@ -238,7 +327,43 @@ fail:
   if (client) {
     rmw_client_free(client);
   }
-  if (response_datareader && dds_subscriber) {
+  if (client_listener) {
+    request_datawriter->set_listener(nullptr, DDS::STATUS_MASK_NONE);
+    response_datareader->set_listener(nullptr, DDS::STATUS_MASK_NONE);
+    RMW_TRY_DESTRUCTOR_FROM_WITHIN_FAILURE(
+      client_listener->~ConnextClientListener(), ConnextClientListener)
+    rmw_free(client_listener);
+  }
+  if (listener_buf) {
+    rmw_free(listener_buf);
+  }
+  if (serialized && request_datawriter) {
+    if (read_condition &&
+      response_datareader->delete_readcondition(read_condition) != DDS::RETCODE_OK)
+    {
+      std::stringstream ss;
+      ss << "leaking readcondition while handling failure at " <<
+        __FILE__ << ":" << __LINE__ << '\n';
+      (std::cerr << ss.str()).flush();
+    }
+    if (shared_client) {
+      RMW_TRY_DESTRUCTOR_FROM_WITHIN_FAILURE(
+        shared_client->~SharedRequesterClient(), SharedRequesterClient)
+      rmw_free(shared_client);
+    }
+    if (shared_client_buf) {
+      rmw_free(shared_client_buf);
+    }
+    // the entities of a shared requester are deleted with its last client
+    if (!shared_requester &&
+      !_delete_serialized_entities(participant, response_datareader, request_datawriter))
+    {
+      std::stringstream ss;
+      ss << "leaking datareader and datawriter while handling failure at " <<
+        __FILE__ << ":" << __LINE__ << '\n';
+      (std::cerr << ss.str()).flush();
+    }
+  } else if (response_datareader && dds_subscriber) {
     if (dds_subscriber->delete_datareader(response_datareader) != DDS::RETCODE_OK) {
       std::stringstream ss;
       ss << "leaking datareader while handling failure at " <<
@@ -259,6 +384,16 @@ fail:
   return NULL;
 }
 
+rmw_client_t *
+rmw_create_client(
+  const rmw_node_t * node,
+  const rosidl_service_type_support_t * type_supports,
+  const char * service_name,
+  const rmw_qos_profile_t * qos_profile)
+{
+  return _create_client(node, type_supports, service_name, qos_profile, false);
+}
+
 rmw_ret_t
 rmw_destroy_client(rmw_node_t * node, rmw_client_t * client)
 {
@@ -283,16 +418,43 @@ rmw_destroy_client(rmw_node_t * node, rmw_client_t * client)
   if (client_info) {
     auto response_datareader = client_info->response_datareader_;
 
-    node_info->subscriber_listener->remove_information(
-      client_info->response_datareader_->get_instance_handle(), EntityType::Subscriber);
-    DDS::DataWriter * request_datawriter = static_cast<DDS::DataWriter *>(
-      client_info->callbacks_->get_request_datawriter(client_info->requester_));
-    node_info->subscriber_listener->trigger_graph_guard_condition();
+    DDS::DataWriter * request_datawriter = client_info->request_datawriter_;
+    if (!request_datawriter) {
+      request_datawriter = static_cast<DDS::DataWriter *>(
+        client_info->callbacks_->get_request_datawriter(client_info->requester_));
+    }
+    // the entities of a shared requester are removed from the graph with its last client
+    if (!client_info->shared_requester_) {
+      node_info->subscriber_listener->remove_information(
+        response_datareader->get_instance_handle(), EntityType::Subscriber);
+      node_info->subscriber_listener->trigger_graph_guard_condition();
+
+      node_info->publisher_listener->remove_information(
+        request_datawriter->get_instance_handle(),
+        EntityType::Publisher);
+      node_info->publisher_listener->trigger_graph_guard_condition();
+    }
 
-    node_info->publisher_listener->remove_information(
-      request_datawriter->get_instance_handle(),
-      EntityType::Publisher);
-    node_info->publisher_listener->trigger_graph_guard_condition();
+    if (client_info->listener_) {
+      request_datawriter->set_listener(nullptr, DDS::STATUS_MASK_NONE);
+      if (response_datareader) {
+        response_datareader->set_listener(nullptr, DDS::STATUS_MASK_NONE);
+      }
+      RMW_TRY_DESTRUCTOR(
+        client_info->listener_->~ConnextClientListener(),
+        ConnextClientListener, result = RMW_RET_ERROR)
+      rmw_free(client_info->listener_);
+      client_info->listener_ = nullptr;
+    }
+
+    if (client_info->in_flight_) {
+      client_info->expiry_condition_ = nullptr;
+      RMW_TRY_DESTRUCTOR(
+        client_info->in_flight_->~InFlightRequests(),
+        InFlightRequests, result = RMW_RET_ERROR)
+      rmw_free(client_info->in_flight_);
+      client_info->in_flight_ = nullptr;
+    }
 
     if (response_datareader) {
       auto read_condition = client_info->read_condition_;
@@ -307,12 +469,29 @@ rmw_destroy_client(rmw_node_t * node, rmw_client_t * client)
       RMW_SET_ERROR_MSG("cannot delete readcondition because the datareader is null");
       result = RMW_RET_ERROR;
     }
+    if (client_info->shared_requester_ && !client_info->read_condition_) {
+      client_info->reply_condition_ = nullptr;
+      RMW_TRY_DESTRUCTOR(
+        client_info->shared_requester_->~SharedRequesterClient(),
+        SharedRequesterClient, result = RMW_RET_ERROR)
+      rmw_free(client_info->shared_requester_);
+      client_info->shared_requester_ = nullptr;
+      client_info->request_datawriter_ = nullptr;
+    }
     const service_type_support_callbacks_t * callbacks = client_info->callbacks_;
     if (callbacks) {
       if (client_info->requester_) {
         callbacks->destroy_requester(client_info->requester_, &rmw_free);
       }
     }
+    if (client_info->request_datawriter_ && !client_info->read_condition_) {
+      if (!_delete_serialized_entities(
+          node_info->participant, response_datareader, client_info->request_datawriter_))
+      {
+        result = RMW_RET_ERROR;
+      }
+      client_info->request_datawriter_ = nullptr;
+    }
 
     RMW_TRY_DESTRUCTOR(
       client_info->~ConnextStaticClientInfo(),
@@ -328,3 +507,18 @@ rmw_destroy_client(rmw_node_t * node, rmw_client_t * client)
   return result;
 }
 }  // extern "C"
+
+namespace rmw_connext_cpp
+{
+
+rmw_client_t *
+create_serialized_client(
+  const rmw_node_t * node,
+  const rosidl_service_type_support_t * type_supports,
+  const char * service_name,
+  const rmw_qos_profile_t * qos_profile)
+{
+  return _create_client(node, type_supports, service_name, qos_profile, true);
+}
+
+}  // namespace rmw_connext_cpp
@@ -12,40 +12,213 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 #include "rmw/error_handling.h"
 #include "rmw/rmw.h"
 #include "rmw/types.h"
 
+#include "rmw_connext_shared_cpp/trace.hpp"
+
 #include "rmw_connext_cpp/connext_static_publisher_info.hpp"
 #include "rmw_connext_cpp/identifier.hpp"
+#include "rmw_connext_cpp/keyed_publish.hpp"
+
+#include "intra_process.hpp"
+#include "serialized_data.hpp"
 
 // include patched generated code from the build folder
 #include "connext_static_serialized_dataSupport.h"
 
+// Buffers handed over to the local subscriptions, at most this many are kept for reuse by
+// a publishing thread, messages in flight beyond them get a buffer of their own.
+static const size_t max_handoff_buffers = 64;
+// Storage for the control block of the shared pointer handing over a pooled buffer.
+static const size_t handoff_control_block_size = 64;
+
+struct HandoffBuffer
+{
+  std::vector<uint8_t> data;
+  alignas(std::max_align_t) unsigned char control_block[handoff_control_block_size];
+};
+
+// Pool of the buffers handed over by a thread, which outlives the thread as long as the
+// subscriptions hold any of its buffers.
+// A buffer only goes back to the free list when its control block is deallocated, after the
+// last reference was released, and the free list is guarded by a mutex, so that the next
+// copy into the buffer happens after all reads of the subscriptions.
+struct HandoffPool
+{
+  HandoffPool()
+  {
+    buffers.reserve(max_handoff_buffers);
+    free_buffers.reserve(max_handoff_buffers);
+  }
+
+  HandoffBuffer *
+  acquire()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!free_buffers.empty()) {
+      HandoffBuffer * buffer = free_buffers.back();
+      free_buffers.pop_back();
+      return buffer;
+    }
+    if (buffers.size() >= max_handoff_buffers) {
+      return nullptr;
+    }
+    buffers.emplace_back(new HandoffBuffer());
+    return buffers.back().get();
+  }
+
+  void
+  release(HandoffBuffer * buffer)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    // does not allocate, the free list has room for all buffers
+    free_buffers.push_back(buffer);
+  }
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<HandoffBuffer>> buffers;
+  std::vector<HandoffBuffer *> free_buffers;
+};
+
+// Allocator placing the control block of a handed over buffer into the buffer itself and
+// giving the buffer back to its pool when the control block is deallocated.
+template<typename T>
+struct HandoffAllocator
+{
+  using value_type = T;
+
+  HandoffAllocator(std::shared_ptr<HandoffPool> pool, HandoffBuffer * buffer)
+  : pool(std::move(pool)), buffer(buffer)
+  {}
+
+  template<typename U>
+  HandoffAllocator(const HandoffAllocator<U> & other)  // NOLINT(runtime/explicit)
+  : pool(other.pool), buffer(other.buffer)
+  {}
+
+  T *
+  allocate(size_t)
+  {
+    static_assert(
+      sizeof(T) <= handoff_control_block_size && alignof(T) <= alignof(std::max_align_t),
+      "the control block does not fit into the storage of the handed over buffer");
+    return reinterpret_cast<T *>(buffer->control_block);
+  }
+
+  void
+  deallocate(T *, size_t)
+  {
+    pool->release(buffer);
+  }
+
+  std::shared_ptr<HandoffPool> pool;
+  HandoffBuffer * buffer;
+};
+
+template<typename T, typename U>
+bool
+operator==(const HandoffAllocator<T> & lhs, const HandoffAllocator<U> & rhs)
+{
+  return lhs.buffer == rhs.buffer;
+}
+
+template<typename T, typename U>
 bool
-publish(DDS::DataWriter * dds_data_writer, const rcutils_uint8_array_t * cdr_stream)
+operator!=(const HandoffAllocator<T> & lhs, const HandoffAllocator<U> & rhs)
+{
+  return lhs.buffer != rhs.buffer;
+}
+
+// Serialization buffer and sample of a thread, reused by all publishers so that publishing
+// does not allocate once the buffer fits the largest message.
+struct PublishScratch
+{
+  PublishScratch()
+  : cdr_stream(rcutils_get_zero_initialized_uint8_array()),
+    instance(ConnextStaticSerializedDataTypeSupport::create_data()),
+    handoff_pool(std::make_shared<HandoffPool>())
+  {
+    cdr_stream.allocator = rcutils_get_default_allocator();
+    if (instance) {
+      // the serialized data is always loaned from the cdr stream
+      instance->serialized_data.maximum(0);
+    }
+  }
+
+  ~PublishScratch()
+  {
+    cdr_stream.allocator.deallocate(cdr_stream.buffer, cdr_stream.allocator.state);
+    if (instance) {
+      ConnextStaticSerializedDataTypeSupport::delete_data(instance);
+    }
+  }
+
+  // Copy a serialized message into a buffer handed over to the local subscriptions.
+  // The buffers are reused once the subscriptions released them, so that delivering in
+  // process does not allocate either once there are enough buffers for the messages queued.
+  std::shared_ptr<const uint8_t>
+  copy_for_intra_process(const uint8_t * buffer, size_t buffer_length)
+  {
+    HandoffBuffer * handoff_buffer = handoff_pool->acquire();
+    if (!handoff_buffer) {
+      auto own_buffer = std::make_shared<std::vector<uint8_t>>(buffer, buffer + buffer_length);
+      return std::shared_ptr<const uint8_t>(own_buffer, own_buffer->data());
+    }
+    handoff_buffer->data.assign(buffer, buffer + buffer_length);
+    // the pooled buffer is owned by the pool, releasing it only gives it back
+    return std::shared_ptr<const uint8_t>(
+      handoff_buffer->data.data(), [](const uint8_t *) {},
+      HandoffAllocator<uint8_t>(handoff_pool, handoff_buffer));
+  }
+
+  rcutils_uint8_array_t cdr_stream;
+  ConnextStaticSerializedData * instance;
+  std::shared_ptr<HandoffPool> handoff_pool;
+};
+
+static PublishScratch &
+get_publish_scratch()
+{
+  static thread_local PublishScratch scratch;
+  return scratch;
+}
+
+DDS::ReturnCode_t
+_write_serialized_data(
+  DDS::DataWriter * dds_data_writer,
+  const rcutils_uint8_array_t * cdr_stream,
+  const DDS::Octet * key_hash,
+  DDS_WriteParams_t & write_params)
 {
   ConnextStaticSerializedDataDataWriter * data_writer =
     ConnextStaticSerializedDataDataWriter::narrow(dds_data_writer);
   if (!data_writer) {
     RMW_SET_ERROR_MSG("failed to narrow data writer");
-    return false;
+    return DDS::RETCODE_ERROR;
   }
 
-  ConnextStaticSerializedData * instance = ConnextStaticSerializedDataTypeSupport::create_data();
+  ConnextStaticSerializedData * instance = get_publish_scratch().instance;
   if (!instance) {
     RMW_SET_ERROR_MSG("failed to create dds message instance");
-    return false;
+    return DDS::RETCODE_ERROR;
   }
 
   DDS::ReturnCode_t status = DDS::RETCODE_ERROR;
 
-  instance->serialized_data.maximum(0);
   if (cdr_stream->buffer_length > (std::numeric_limits<DDS_Long>::max)()) {
     RMW_SET_ERROR_MSG("cdr_stream->buffer_length unexpectedly larger than DDS_Long's max value");
-    return false;
+    return DDS::RETCODE_ERROR;
   }
   if (!instance->serialized_data.loan_contiguous(
       reinterpret_cast<DDS::Octet *>(cdr_stream->buffer),
@@ -53,32 +226,55 @@ publish(DDS::DataWriter * dds_data_writer, const rcutils_uint8_array_t * cdr_str
       static_cast<DDS::Long>(cdr_stream->buffer_length)))
   {
     RMW_SET_ERROR_MSG("failed to loan memory for message");
-    goto cleanup;
+    return DDS::RETCODE_ERROR;
+  }
+  if (key_hash) {
+    memcpy(instance->key_hash, key_hash, KEY_HASH_LENGTH_16);
+  } else {
+    memset(instance->key_hash, 0, KEY_HASH_LENGTH_16);
   }
 
-  status = data_writer->write(*instance, DDS::HANDLE_NIL);
+  // unlike write(), this returns the identity given to the sample, which Connext only
+  // writes back to the parameters if asked to replace the automatic identity
+  write_params.replace_auto = DDS_BOOLEAN_TRUE;
+  RMW_CONNEXT_TRACEPOINT(write_entry, data_writer->get_instance_handle().keyHash.value);
+  status = data_writer->write_w_params(*instance, write_params);
+  RMW_CONNEXT_TRACEPOINT(
+    write_exit, data_writer->get_instance_handle().keyHash.value,
+    RMW_CONNEXT_TRACE_SEQUENCE_NUMBER(write_params.identity.sequence_number), status);
+  if (status == DDS::RETCODE_OK &&
+    write_params.identity.sequence_number.high == DDS_AUTO_SEQUENCE_NUMBER.high &&
+    write_params.identity.sequence_number.low == DDS_AUTO_SEQUENCE_NUMBER.low)
+  {
+    RMW_SET_ERROR_MSG("datawriter did not return the sequence number of the sample");
+    status = DDS::RETCODE_ERROR;
+  }
 
-cleanup:
-  if (instance) {
-    if (!instance->serialized_data.unloan()) {
-      fprintf(stderr, "failed to return loaned memory\n");
-      status = DDS::RETCODE_ERROR;
-    }
-    ConnextStaticSerializedDataTypeSupport::delete_data(instance);
+  if (!instance->serialized_data.unloan()) {
+    fprintf(stderr, "failed to return loaned memory\n");
+    status = DDS::RETCODE_ERROR;
   }
 
-  return status == DDS::RETCODE_OK;
+  return status;
 }
 
-extern "C"
+static bool
+publish(
+  DDS::DataWriter * dds_data_writer,
+  const rcutils_uint8_array_t * cdr_stream,
+  const DDS::Octet * key_hash)
 {
-rmw_ret_t
-rmw_publish(
+  DDS_WriteParams_t write_params = DDS_WRITEPARAMS_DEFAULT;
+  return _write_serialized_data(dds_data_writer, cdr_stream, key_hash, write_params) ==
+         DDS::RETCODE_OK;
+}
+
+static rmw_ret_t
+_publish(
   const rmw_publisher_t * publisher,
   const void * ros_message,
-  rmw_publisher_allocation_t * allocation)
+  const DDS::Octet * key_hash)
 {
-  (void) allocation;
   if (!publisher) {
     RMW_SET_ERROR_MSG("publisher handle is null");
     return RMW_RET_ERROR;
@@ -108,44 +304,55 @@ rmw_publish(
     RMW_SET_ERROR_MSG("topic writer handle is null");
     return RMW_RET_ERROR;
   }
+  IntraProcessPublisher * intra_process = publisher_info->intra_process_;
 
-  auto ret = RMW_RET_OK;
-  rcutils_uint8_array_t cdr_stream = rcutils_get_zero_initialized_uint8_array();
-  cdr_stream.allocator = rcutils_get_default_allocator();
+  rcutils_uint8_array_t & cdr_stream = get_publish_scratch().cdr_stream;
 
+  auto serialize_start = std::chrono::steady_clock::now();
+  RMW_CONNEXT_TRACEPOINT(to_cdr_stream_entry, publisher_info->publisher_gid.data);
+  // the type support only reallocates the buffer if the message does not fit its capacity
   if (!callbacks->to_cdr_stream(ros_message, &cdr_stream)) {
     RMW_SET_ERROR_MSG("failed to convert ros_message to cdr stream");
-    ret = RMW_RET_ERROR;
-    goto fail;
+    return RMW_RET_ERROR;
+  }
+  RMW_CONNEXT_TRACEPOINT(
+    to_cdr_stream_exit, publisher_info->publisher_gid.data, cdr_stream.buffer_length);
+  publisher_info->serialize_time_.record(std::chrono::steady_clock::now() - serialize_start);
+  // a reallocated buffer has exactly the length of the message, but the capacity is not updated
+  if (cdr_stream.buffer_capacity < cdr_stream.buffer_length) {
+    cdr_stream.buffer_capacity = cdr_stream.buffer_length;
   }
   if (cdr_stream.buffer_length == 0) {
     RMW_SET_ERROR_MSG("no message length set");
-    ret = RMW_RET_ERROR;
-    goto fail;
+    return RMW_RET_ERROR;
   }
   if (!cdr_stream.buffer) {
     RMW_SET_ERROR_MSG("no serialized message attached");
-    ret = RMW_RET_ERROR;
-    goto fail;
+    return RMW_RET_ERROR;
   }
-  if (!publish(topic_writer, &cdr_stream)) {
-    RMW_SET_ERROR_MSG("failed to publish message");
-    ret = RMW_RET_ERROR;
-    goto fail;
+  // the datawriter is skipped if only subscriptions delivered in process are matched
+  if (!intra_process ||
+    intra_process->has_remote_subscriptions(publisher_info->listener_->match_changes()))
+  {
+    if (!publish(topic_writer, &cdr_stream, key_hash)) {
+      RMW_SET_ERROR_MSG("failed to publish message");
+      return RMW_RET_ERROR;
+    }
   }
-
-fail:
-  cdr_stream.allocator.deallocate(cdr_stream.buffer, cdr_stream.allocator.state);
-  return ret;
+  if (intra_process && intra_process->has_local_subscriptions()) {
+    intra_process->publish(
+      get_publish_scratch().copy_for_intra_process(cdr_stream.buffer, cdr_stream.buffer_length),
+      cdr_stream.buffer_length);
+  }
+  return RMW_RET_OK;
 }
 
-rmw_ret_t
-rmw_publish_serialized_message(
+static rmw_ret_t
+_publish_serialized_message(
   const rmw_publisher_t * publisher,
   const rmw_serialized_message_t * serialized_message,
-  rmw_publisher_allocation_t * allocation)
+  const DDS::Octet * key_hash)
 {
-  (void) allocation;
   if (!publisher) {
     RMW_SET_ERROR_MSG("publisher handle is null");
     return RMW_RET_ERROR;
@@ -176,11 +383,135 @@ rmw_publish_serialized_message(
     return RMW_RET_ERROR;
   }
 
-  bool published = publish(topic_writer, serialized_message);
-  if (!published) {
-    RMW_SET_ERROR_MSG("failed to publish message");
-    return RMW_RET_ERROR;
+  IntraProcessPublisher * intra_process = publisher_info->intra_process_;
+  if (!intra_process ||
+    intra_process->has_remote_subscriptions(publisher_info->listener_->match_changes()))
+  {
+    bool published = publish(topic_writer, serialized_message, key_hash);
+    if (!published) {
+      RMW_SET_ERROR_MSG("failed to publish message");
+      return RMW_RET_ERROR;
+    }
+  }
+  if (intra_process && intra_process->has_local_subscriptions()) {
+    // the serialized message stays owned by the caller
+    intra_process->publish(
+      get_publish_scratch().copy_for_intra_process(
+        serialized_message->buffer, serialized_message->buffer_length),
+      serialized_message->buffer_length);
   }
   return RMW_RET_OK;
 }
+
+// GID of a publisher for the tracepoints, which also mark calls with an invalid publisher.
+static inline const uint8_t *
+_get_trace_gid(const rmw_publisher_t * publisher)
+{
+  if (!publisher || publisher->implementation_identifier != rti_connext_identifier ||
+    !publisher->data)
+  {
+    return nullptr;
+  }
+  return static_cast<ConnextStaticPublisherInfo *>(publisher->data)->publisher_gid.data;
+}
+
+extern "C"
+{
+rmw_ret_t
+rmw_publish(
+  const rmw_publisher_t * publisher,
+  const void * ros_message,
+  rmw_publisher_allocation_t * allocation)
+{
+  (void) allocation;
+  RMW_CONNEXT_TRACEPOINT(rmw_publish_entry, _get_trace_gid(publisher));
+  rmw_ret_t ret = _publish(publisher, ros_message, nullptr);
+  RMW_CONNEXT_TRACEPOINT(rmw_publish_exit, _get_trace_gid(publisher), ret);
+  return ret;
+}
+
+rmw_ret_t
+rmw_publish_serialized_message(
+  const rmw_publisher_t * publisher,
+  const rmw_serialized_message_t * serialized_message,
+  rmw_publisher_allocation_t * allocation)
+{
+  (void) allocation;
+  return _publish_serialized_message(publisher, serialized_message, nullptr);
+}
 }  // extern "C"
+
+// Turn the key of a sample into the key hash identifying its instance.
+static rmw_ret_t
+_get_key_hash(
+  const rmw_publisher_t * publisher,
+  const void * key,
+  size_t key_length,
+  DDS::Octet * key_hash)
+{
+  if (!publisher) {
+    RMW_SET_ERROR_MSG("publisher handle is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  if (publisher->implementation_identifier != rti_connext_identifier) {
+    RMW_SET_ERROR_MSG("publisher handle is not from this rmw implementation");
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION;
+  }
+  if (!key) {
+    RMW_SET_ERROR_MSG("key is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  // keys which fit into the key hash are used as is, like the key hash of RTPS does
+  if (key_length == 0 || key_length > static_cast<size_t>(KEY_HASH_LENGTH_16)) {
+    RMW_SET_ERROR_MSG("key length has to be between 1 and 16 bytes");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  auto publisher_info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!publisher_info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return RMW_RET_ERROR;
+  }
+  if (!publisher_info->keyed_) {
+    RMW_SET_ERROR_MSG("topic of the publisher is not keyed");
+    return RMW_RET_ERROR;
+  }
+
+  memset(key_hash, 0, KEY_HASH_LENGTH_16);
+  memcpy(key_hash, key, key_length);
+  return RMW_RET_OK;
+}
+
+namespace rmw_connext_cpp
+{
+
+rmw_ret_t
+publish_with_key(
+  const rmw_publisher_t * publisher,
+  const void * ros_message,
+  const void * key,
+  size_t key_length)
+{
+  DDS::Octet key_hash[KEY_HASH_LENGTH_16];
+  rmw_ret_t ret = _get_key_hash(publisher, key, key_length, key_hash);
+  if (ret != RMW_RET_OK) {
+    return ret;
+  }
+  return _publish(publisher, ros_message, key_hash);
+}
+
+rmw_ret_t
+publish_serialized_message_with_key(
+  const rmw_publisher_t * publisher,
+  const rmw_serialized_message_t * serialized_message,
+  const void * key,
+  size_t key_length)
+{
+  DDS::Octet key_hash[KEY_HASH_LENGTH_16];
+  rmw_ret_t ret = _get_key_hash(publisher, key, key_length, key_hash);
+  if (ret != RMW_RET_OK) {
+    return ret;
+  }
+  return _publish_serialized_message(publisher, serialized_message, key_hash);
+}
+
+}  // namespace rmw_connext_cpp
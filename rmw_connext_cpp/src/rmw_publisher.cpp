@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
 #include <string>
 
 #include "rmw/allocators.h"
@@ -25,13 +26,13 @@
 
 #include "rmw_connext_cpp/identifier.hpp"
 
+#include "intra_process.hpp"
+#include "keyed_topic.hpp"
 #include "process_topic_and_service_names.hpp"
+#include "publisher_loan_pool.hpp"
 #include "type_support_common.hpp"
 #include "rmw_connext_cpp/connext_static_publisher_info.hpp"
 
-// include patched generated code from the build folder
-#include "connext_static_serialized_dataSupport.h"
-
 // Uncomment this to get extra console output about discovery.
 // This affects code in this file, but there is a similar variable in:
 //   rmw_connext_shared_cpp/shared_functions.cpp
@@ -119,10 +120,14 @@ rmw_create_publisher(
   DDS::TopicDescription * topic_description = nullptr;
   void * info_buf = nullptr;
   void * listener_buf = nullptr;
+  void * intra_process_buf = nullptr;
+  std::shared_ptr<IntraProcessTopic> intra_process_topic;
   ConnextPublisherListener * publisher_listener = nullptr;
   ConnextStaticPublisherInfo * publisher_info = nullptr;
   rmw_publisher_t * publisher = nullptr;
   std::string mangled_name = "";
+  bool keyed = false;
+  bool type_registered = false;
 
   char * topic_str = nullptr;
 
@@ -138,19 +143,6 @@ rmw_create_publisher(
     RMW_SET_ERROR_MSG("failed to fetch type code\n");
     goto fail;
   }
-  // This is a non-standard RTI Connext function
-  // It allows to register an external type to a static data writer
-  // In this case, we register the custom message type to a data writer,
-  // which only publishes DDS_Octets
-  // The purpose of this is to send only raw data DDS_Octets over the wire,
-  // advertise the topic however with a type of the message, e.g. std_msgs::msg::dds_::String
-  status = ConnextStaticSerializedDataSupport_register_external_type(
-    participant, type_name.c_str(), type_code);
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to register external type");
-    goto fail;
-  }
-
   status = participant->get_default_publisher_qos(publisher_qos);
   if (status != DDS::RETCODE_OK) {
     RMW_SET_ERROR_MSG("failed to get default publisher qos");
@@ -165,6 +157,11 @@ rmw_create_publisher(
   {
     goto fail;
   }
+  if (!_register_serialized_data_type(node_info, topic_str, type_name, type_code, keyed)) {
+    // error string was set within the function
+    goto fail;
+  }
+  type_registered = true;
 
   // Allocate memory for the PublisherListener object.
   listener_buf = rmw_allocate(sizeof(ConnextPublisherListener));
@@ -207,13 +204,24 @@ rmw_create_publisher(
       goto fail;
     }
   }
-  DDS::String_free(topic_str);
-  topic_str = nullptr;
-
-  if (!get_datawriter_qos(participant, *qos_profile, datawriter_qos)) {
+  if (!get_datawriter_qos(participant, *qos_profile, topic_str, datawriter_qos)) {
+    // error string was set within the function
+    goto fail;
+  }
+  if (!check_datawriter_qos_for_type(datawriter_qos, topic_str, type_code)) {
+    // error string was set within the function
+    goto fail;
+  }
+  // the in process queue keeps no history per instance
+  if (!keyed &&
+    !IntraProcessTopic::get(
+      node_info->context, participant, topic_str, type_name, intra_process_topic))
+  {
     // error string was set within the function
     goto fail;
   }
+  DDS::String_free(topic_str);
+  topic_str = nullptr;
 
   topic_writer = dds_publisher->create_datawriter(
     topic, datawriter_qos, NULL, DDS::STATUS_MASK_NONE);
@@ -234,9 +242,24 @@ rmw_create_publisher(
   publisher_info->dds_publisher_ = dds_publisher;
   publisher_info->topic_writer_ = topic_writer;
   publisher_info->callbacks_ = callbacks;
+  publisher_info->keyed_ = keyed;
   publisher_info->publisher_gid.implementation_identifier = rti_connext_identifier;
   publisher_info->listener_ = publisher_listener;
   publisher_listener = nullptr;
+  // late joining subscriptions need the history of the datawriter, which is not kept in process
+  if (intra_process_topic &&
+    datawriter_qos.durability.kind == DDS::VOLATILE_DURABILITY_QOS)
+  {
+    intra_process_buf = rmw_allocate(sizeof(IntraProcessPublisher));
+    if (!intra_process_buf) {
+      RMW_SET_ERROR_MSG("failed to allocate memory for intra process publisher");
+      goto fail;
+    }
+    RMW_TRY_PLACEMENT_NEW(
+      publisher_info->intra_process_, intra_process_buf, goto fail, IntraProcessPublisher,
+      intra_process_topic, topic_writer, datawriter_qos)
+    intra_process_buf = nullptr;
+  }
   static_assert(
     sizeof(ConnextPublisherGID) <= RMW_GID_STORAGE_SIZE,
     "RMW_GID_STORAGE_SIZE insufficient to store the rmw_connext_cpp GID implemenation."
@@ -290,6 +313,12 @@ fail:
   if (publisher) {
     rmw_publisher_free(publisher);
   }
+  if (publisher_info && publisher_info->intra_process_) {
+    RMW_TRY_DESTRUCTOR_FROM_WITHIN_FAILURE(
+      publisher_info->intra_process_->~IntraProcessPublisher(), IntraProcessPublisher)
+    rmw_free(publisher_info->intra_process_);
+    publisher_info->intra_process_ = nullptr;
+  }
   if (dds_publisher) {
     if (topic_writer) {
       if (dds_publisher->delete_datawriter(topic_writer) != DDS::RETCODE_OK) {
@@ -306,6 +335,9 @@ fail:
       (std::cerr << ss.str()).flush();
     }
   }
+  if (type_registered) {
+    _unregister_serialized_data_type(node_info, type_name);
+  }
   if (publisher_listener) {
     RMW_TRY_DESTRUCTOR_FROM_WITHIN_FAILURE(
       publisher_listener->~ConnextPublisherListener(), ConnextPublisherListener)
@@ -327,6 +359,9 @@ fail:
   if (listener_buf) {
     rmw_free(listener_buf);
   }
+  if (intra_process_buf) {
+    rmw_free(intra_process_buf);
+  }
 
   return NULL;
 }
@@ -468,6 +503,21 @@ rmw_destroy_publisher(rmw_node_t * node, rmw_publisher_t * publisher)
     node_info->publisher_listener->trigger_graph_guard_condition();
     DDS::Publisher * dds_publisher = publisher_info->dds_publisher_;
 
+    if (publisher_info->intra_process_) {
+      RMW_TRY_DESTRUCTOR(
+        publisher_info->intra_process_->~IntraProcessPublisher(),
+        IntraProcessPublisher, return RMW_RET_ERROR)
+      rmw_free(publisher_info->intra_process_);
+      publisher_info->intra_process_ = nullptr;
+    }
+    if (publisher_info->loan_pool_) {
+      RMW_TRY_DESTRUCTOR(
+        publisher_info->loan_pool_->~PublisherLoanPool(),
+        PublisherLoanPool, return RMW_RET_ERROR)
+      rmw_free(publisher_info->loan_pool_);
+      publisher_info->loan_pool_ = nullptr;
+    }
+
     if (dds_publisher) {
       if (publisher_info->topic_writer_) {
         if (dds_publisher->delete_datawriter(publisher_info->topic_writer_) != DDS::RETCODE_OK) {
@@ -486,6 +536,9 @@ rmw_destroy_publisher(rmw_node_t * node, rmw_publisher_t * publisher)
       return RMW_RET_ERROR;
     }
 
+    _unregister_serialized_data_type(
+      node_info, _create_type_name(publisher_info->callbacks_, "msg"));
+
     ConnextPublisherListener * pub_listener = publisher_info->listener_;
     if (pub_listener) {
       RMW_TRY_DESTRUCTOR(
@@ -12,14 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
+
 #include "rmw/error_handling.h"
 #include "rmw/impl/cpp/macros.hpp"
 #include "rmw/rmw.h"
 
+#include "rmw_connext_shared_cpp/trace.hpp"
+
 #include "rmw_connext_cpp/identifier.hpp"
 #include "rmw_connext_cpp/connext_static_client_info.hpp"
 #include "rmw_connext_cpp/connext_static_service_info.hpp"
 
+#include "in_flight_requests.hpp"
+
 extern "C"
 {
 rmw_ret_t
@@ -58,7 +64,27 @@ rmw_send_request(
     return RMW_RET_ERROR;
   }
 
-  *sequence_id = callbacks->send_request(requester, ros_request);
+  InFlightRequests * in_flight = client_info->in_flight_;
+  if (in_flight && !in_flight->reserve()) {
+    // like a full request queue, the request can be sent again once responses arrived
+    RMW_SET_ERROR_MSG("too many requests in flight");
+    return RMW_RET_TIMEOUT;
+  }
+  // the slot is released if the request is not written, also if sending it throws
+  InFlightReservation reservation(in_flight);
+
+  RMW_CONNEXT_TRACEPOINT(send_request_entry, client);
+  try {
+    *sequence_id = callbacks->send_request(requester, ros_request);
+  } catch (const connext::TimeoutException &) {
+    // the datawriter of a bounded request queue does not block while the queue is full
+    RMW_SET_ERROR_MSG("request queue of the service is full");
+    return RMW_RET_TIMEOUT;
+  }
+  RMW_CONNEXT_TRACEPOINT(send_request_exit, client, *sequence_id);
+  reservation.add(*sequence_id);
+  client_info->requests_sent_.fetch_add(1, std::memory_order_relaxed);
+  client_info->request_times_.add(nullptr, *sequence_id);
   return RMW_RET_OK;
 }
 
@@ -110,7 +136,17 @@ rmw_take_request(
     return RMW_RET_ERROR;
   }
 
+  RMW_CONNEXT_TRACEPOINT(take_request_entry, service);
   *taken = callbacks->take_request(replier, request_header, ros_request);
+  // the request is identified by the GUID of the request writer of the client
+  RMW_CONNEXT_TRACEPOINT(
+    take_request_exit, service, *taken, request_header->writer_guid,
+    request_header->sequence_number);
+  if (*taken) {
+    service_info->requests_taken_.fetch_add(1, std::memory_order_relaxed);
+    service_info->request_times_.add(
+      request_header->writer_guid, request_header->sequence_number);
+  }
 
   return RMW_RET_OK;
 }
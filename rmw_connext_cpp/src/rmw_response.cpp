@@ -12,14 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
+
 #include "rmw/error_handling.h"
 #include "rmw/impl/cpp/macros.hpp"
 #include "rmw/rmw.h"
 
+#include "rmw_connext_shared_cpp/trace.hpp"
+
 #include "rmw_connext_cpp/identifier.hpp"
 #include "rmw_connext_cpp/connext_static_client_info.hpp"
 #include "rmw_connext_cpp/connext_static_service_info.hpp"
 
+#include "in_flight_requests.hpp"
+
 extern "C"
 {
 rmw_ret_t
@@ -70,7 +76,29 @@ rmw_take_response(
     return RMW_RET_ERROR;
   }
 
+  RMW_CONNEXT_TRACEPOINT(take_response_entry, client);
   *taken = callbacks->take_response(requester, request_header, ros_response);
+  InFlightRequests * in_flight = client_info->in_flight_;
+  if (in_flight) {
+    // responses to expired requests are dropped, the typed sample is already deserialized
+    while (*taken && !in_flight->complete(request_header->sequence_number)) {
+      *taken = callbacks->take_response(requester, request_header, ros_response);
+    }
+    if (!*taken) {
+      // the client may have been woken up by expired requests, they have been reported
+      in_flight->reset_condition();
+    }
+  }
+  std::chrono::nanoseconds round_trip_time;
+  if (*taken &&
+    client_info->request_times_.remove(
+      nullptr, request_header->sequence_number, round_trip_time))
+  {
+    client_info->round_trip_time_.record(round_trip_time);
+  }
+  RMW_CONNEXT_TRACEPOINT(
+    take_response_exit, client, *taken, request_header->writer_guid,
+    request_header->sequence_number);
 
   return RMW_RET_OK;
 }
@@ -118,7 +146,28 @@ rmw_send_response(
     return RMW_RET_ERROR;
   }
 
-  callbacks->send_response(replier, request_header, ros_response);
+  RMW_CONNEXT_TRACEPOINT(
+    send_response_entry, service, request_header->writer_guid, request_header->sequence_number);
+  bool sent = true;
+  try {
+    callbacks->send_response(replier, request_header, ros_response);
+  } catch (const connext::TimeoutException &) {
+    // the datawriter stayed full past the response timeout, e.g. because of a slow client,
+    // the response is dropped instead of blocking the executor
+    sent = false;
+  }
+  RMW_CONNEXT_TRACEPOINT(send_response_exit, service, request_header->sequence_number);
+  std::chrono::nanoseconds response_time;
+  if (service_info->request_times_.remove(
+      request_header->writer_guid, request_header->sequence_number, response_time))
+  {
+    if (sent) {
+      service_info->response_time_.record(response_time);
+    }
+  }
+  if (!sent) {
+    service_info->responses_dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
 
   return RMW_RET_OK;
 }
@@ -22,7 +22,9 @@
 #include "rmw_connext_shared_cpp/types.hpp"
 
 #include "rmw_connext_cpp/identifier.hpp"
+#include "rmw_connext_cpp/serialized_service.hpp"
 #include "process_topic_and_service_names.hpp"
+#include "serialized_service.hpp"
 #include "type_support_common.hpp"
 #include "rmw_connext_cpp/connext_static_service_info.hpp"
 
@@ -33,12 +35,13 @@
 
 extern "C"
 {
-rmw_service_t *
-rmw_create_service(
+static rmw_service_t *
+_create_service(
   const rmw_node_t * node,
   const rosidl_service_type_support_t * type_supports,
   const char * service_name,
-  const rmw_qos_profile_t * qos_profile)
+  const rmw_qos_profile_t * qos_profile,
+  bool serialized)
 {
   if (!node) {
     RMW_SET_ERROR_MSG("node handle is null");
@@ -74,6 +77,23 @@ rmw_create_service(
     return NULL;
   }
 
+  // Connext keeps the first type registered under a name, so a node can not use the types
+  // of a service both typed and serialized
+  if (serialized) {
+    if (!_register_serialized_service_types(node_info, callbacks)) {
+      // error string was set within the function
+      return NULL;
+    }
+  } else if (!_check_typed_service_types(node_info, callbacks)) {
+    // error string was set within the function
+    return NULL;
+  }
+  // the reply datawriter filters the replies to serialized clients for each of them
+  if (!_register_reply_filter(participant)) {
+    // error string was set within the function
+    return NULL;
+  }
+
   // Past this point, a failure results in unrolling code in the goto fail block.
   DDS::DataReaderQos datareader_qos;
   DDS::DataWriterQos datawriter_qos;
@@ -102,16 +122,6 @@ rmw_create_service(
     goto fail;
   }
 
-  if (!get_datareader_qos(participant, *qos_profile, datareader_qos)) {
-    // error string was set within the function
-    goto fail;
-  }
-
-  if (!get_datawriter_qos(participant, *qos_profile, datawriter_qos)) {
-    // error string was set within the function
-    goto fail;
-  }
-
   // allocating memory for request topic and response topic strings
   if (!_process_service_name(
       service_name,
@@ -122,19 +132,43 @@ rmw_create_service(
     goto fail;
   }
 
-  replier = callbacks->create_replier(
-    participant, request_topic_str, response_topic_str,
-    &datareader_qos, &datawriter_qos,
-    reinterpret_cast<void **>(&request_datareader),
-    reinterpret_cast<void **>(&response_datawriter),
-    &rmw_allocate);
+  if (!get_datareader_qos(participant, *qos_profile, request_topic_str, datareader_qos)) {
+    // error string was set within the function
+    goto fail;
+  }
+
+  if (!get_datawriter_qos(participant, *qos_profile, response_topic_str, datawriter_qos)) {
+    // error string was set within the function
+    goto fail;
+  }
+  // Every requester reads the replies through a content filter on its own writer GUID.
+  // The reply datawriter only evaluates the filters of a limited number of readers, the
+  // replies to any further clients would be sent to all of them and dropped on arrival.
+  datawriter_qos.writer_resource_limits.max_remote_reader_filters = DDS::LENGTH_UNLIMITED;
+
+  if (serialized) {
+    if (!_create_serialized_replier(
+        participant, callbacks, request_topic_str, response_topic_str,
+        datareader_qos, datawriter_qos, &request_datareader, &response_datawriter))
+    {
+      // error string was set within the function
+      goto fail;
+    }
+  } else {
+    replier = callbacks->create_replier(
+      participant, request_topic_str, response_topic_str,
+      &datareader_qos, &datawriter_qos,
+      reinterpret_cast<void **>(&request_datareader),
+      reinterpret_cast<void **>(&response_datawriter),
+      &rmw_allocate);
+  }
 
   DDS::String_free(request_topic_str);
   request_topic_str = nullptr;
   DDS::String_free(response_topic_str);
   response_topic_str = nullptr;
 
-  if (!replier) {
+  if (!serialized && !replier) {
     RMW_SET_ERROR_MSG("failed to create replier");
     goto fail;
   }
@@ -186,6 +220,9 @@ rmw_create_service(
   service_info->callbacks_ = callbacks;
   service_info->request_datareader_ = request_datareader;
   service_info->read_condition_ = read_condition;
+  if (serialized) {
+    service_info->response_datawriter_ = response_datawriter;
+  }
 
   service->implementation_identifier = rti_connext_identifier;
   service->data = service_info;
@@ -248,7 +285,14 @@ fail:
         (std::cerr << ss.str()).flush();
       }
     }
-    if (dds_subscriber) {
+    if (serialized) {
+      if (!_delete_serialized_entities(participant, request_datareader, response_datawriter)) {
+        std::stringstream ss;
+        ss << "leaking datareader and datawriter while handling failure at " <<
+          __FILE__ << ":" << __LINE__ << '\n';
+        (std::cerr << ss.str()).flush();
+      }
+    } else if (dds_subscriber) {
       if (dds_subscriber->delete_datareader(request_datareader) != DDS::RETCODE_OK) {
         std::stringstream ss;
         ss << "leaking datareader while handling failure at " <<
@@ -271,6 +315,16 @@ fail:
   return NULL;
 }
 
+rmw_service_t *
+rmw_create_service(
+  const rmw_node_t * node,
+  const rosidl_service_type_support_t * type_supports,
+  const char * service_name,
+  const rmw_qos_profile_t * qos_profile)
+{
+  return _create_service(node, type_supports, service_name, qos_profile, false);
+}
+
 rmw_ret_t
 rmw_destroy_service(rmw_node_t * node, rmw_service_t * service)
 {
@@ -300,13 +354,20 @@ rmw_destroy_service(rmw_node_t * node, rmw_service_t * service)
       EntityType::Subscriber);
     node_info->subscriber_listener->trigger_graph_guard_condition();
 
-    DDS::DataWriter * reply_datawriter = static_cast<DDS::DataWriter *>(
-      service_info->callbacks_->get_reply_datawriter(service_info->replier_));
+    DDS::DataWriter * reply_datawriter = service_info->response_datawriter_;
+    if (!reply_datawriter) {
+      reply_datawriter = static_cast<DDS::DataWriter *>(
+        service_info->callbacks_->get_reply_datawriter(service_info->replier_));
+    }
     node_info->publisher_listener->remove_information(
       reply_datawriter->get_instance_handle(),
       EntityType::Publisher);
     node_info->publisher_listener->trigger_graph_guard_condition();
 
+    if (!_delete_request_lanes(service_info)) {
+      result = RMW_RET_ERROR;
+    }
+
     if (request_datareader) {
       auto read_condition = service_info->read_condition_;
       if (read_condition) {
@@ -326,6 +387,14 @@ rmw_destroy_service(rmw_node_t * node, rmw_service_t * service)
         callbacks->destroy_replier(service_info->replier_, &rmw_free);
       }
     }
+    if (service_info->response_datawriter_ && !service_info->read_condition_) {
+      if (!_delete_serialized_entities(
+          node_info->participant, request_datareader, service_info->response_datawriter_))
+      {
+        result = RMW_RET_ERROR;
+      }
+      service_info->response_datawriter_ = nullptr;
+    }
 
     RMW_TRY_DESTRUCTOR(
       service_info->~ConnextStaticServiceInfo(),
@@ -341,3 +410,18 @@ rmw_destroy_service(rmw_node_t * node, rmw_service_t * service)
   return result;
 }
 }  // extern "C"
+
+namespace rmw_connext_cpp
+{
+
+rmw_service_t *
+create_serialized_service(
+  const rmw_node_t * node,
+  const rosidl_service_type_support_t * type_supports,
+  const char * service_name,
+  const rmw_qos_profile_t * qos_profile)
+{
+  return _create_service(node, type_supports, service_name, qos_profile, true);
+}
+
+}  // namespace rmw_connext_cpp
@@ -12,6 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
+#include <limits>
+#include <memory>
 #include <string>
 
 #include "rmw/allocators.h"
@@ -22,15 +25,16 @@
 #include "rmw_connext_shared_cpp/qos.hpp"
 #include "rmw_connext_shared_cpp/types.hpp"
 
+#include "rmw_connext_cpp/content_filtered_subscription.hpp"
 #include "rmw_connext_cpp/identifier.hpp"
 
+#include "intra_process.hpp"
+#include "keyed_topic.hpp"
 #include "process_topic_and_service_names.hpp"
+#include "subscription_loan_pool.hpp"
 #include "type_support_common.hpp"
 #include "rmw_connext_cpp/connext_static_subscriber_info.hpp"
 
-// include patched generated code from the build folder
-#include "connext_static_serialized_dataSupport.h"
-
 // Uncomment this to get extra console output about discovery.
 // This affects code in this file, but there is a similar variable in:
 //   rmw_connext_shared_cpp/shared_functions.cpp
@@ -61,13 +65,15 @@ rmw_fini_subscription_allocation(rmw_subscription_allocation_t * allocation)
   return RMW_RET_ERROR;
 }
 
-rmw_subscription_t *
-rmw_create_subscription(
+static rmw_subscription_t *
+_create_subscription(
   const rmw_node_t * node,
   const rosidl_message_type_support_t * type_supports,
   const char * topic_name,
   const rmw_qos_profile_t * qos_profile,
-  bool ignore_local_publications)
+  bool ignore_local_publications,
+  const char * filter_expression,
+  const rcutils_string_array_t * filter_parameters)
 {
   if (!node) {
     RMW_SET_ERROR_MSG("node handle is null");
@@ -111,14 +117,21 @@ rmw_create_subscription(
   DDS::Subscriber * dds_subscriber = nullptr;
   DDS::Topic * topic = nullptr;
   DDS::TopicDescription * topic_description = nullptr;
+  DDS::ContentFilteredTopic * content_filtered_topic = nullptr;
+  DDS::StringSeq parameters;
   DDS::DataReader * topic_reader = nullptr;
   DDS::ReadCondition * read_condition = nullptr;
+  bool check_local_publications = ignore_local_publications;
   void * info_buf = nullptr;
   void * listener_buf = nullptr;
+  void * intra_process_buf = nullptr;
+  std::shared_ptr<IntraProcessTopic> intra_process_topic;
   ConnextSubscriberListener * subscriber_listener = nullptr;
   ConnextStaticSubscriberInfo * subscriber_info = nullptr;
   rmw_subscription_t * subscription = nullptr;
   std::string mangled_name;
+  bool keyed = false;
+  bool type_registered = false;
 
   char * topic_str = nullptr;
 
@@ -134,19 +147,6 @@ rmw_create_subscription(
     RMW_SET_ERROR_MSG("failed to fetch type code\n");
     goto fail;
   }
-  // This is a non-standard RTI Connext function
-  // It allows to register an external type to a static data writer
-  // In this case, we register the custom message type to a data writer,
-  // which only publishes DDS_Octets
-  // The purpose of this is to send only raw data DDS_Octets over the wire,
-  // advertise the topic however with a type of the message, e.g. std_msgs::msg::dds_::String
-  status = ConnextStaticSerializedDataSupport_register_external_type(
-    participant, type_name.c_str(), type_code);
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to register external type");
-    goto fail;
-  }
-
   status = participant->get_default_subscriber_qos(subscriber_qos);
   if (status != DDS::RETCODE_OK) {
     RMW_SET_ERROR_MSG("failed to get default subscriber qos");
@@ -161,6 +161,11 @@ rmw_create_subscription(
   {
     goto fail;
   }
+  if (!_register_serialized_data_type(node_info, topic_str, type_name, type_code, keyed)) {
+    // error string was set within the function
+    goto fail;
+  }
+  type_registered = true;
 
   // Allocate memory for the SubscriberListener object.
   listener_buf = rmw_allocate(sizeof(ConnextSubscriberListener));
@@ -173,7 +178,8 @@ rmw_create_subscription(
   listener_buf = nullptr;  // Only free the buffer pointer.
 
   dds_subscriber = participant->create_subscriber(
-    subscriber_qos, subscriber_listener, DDS::SUBSCRIPTION_MATCHED_STATUS);
+    subscriber_qos, subscriber_listener,
+    DDS::SUBSCRIPTION_MATCHED_STATUS | DDS::SAMPLE_LOST_STATUS | DDS::SAMPLE_REJECTED_STATUS);
   if (!dds_subscriber) {
     RMW_SET_ERROR_MSG("failed to create subscriber");
     goto fail;
@@ -203,16 +209,55 @@ rmw_create_subscription(
       goto fail;
     }
   }
-  DDS::String_free(topic_str);
-  topic_str = nullptr;
-
-  if (!get_datareader_qos(participant, *qos_profile, datareader_qos)) {
+  if (!get_datareader_qos(participant, *qos_profile, topic_str, datareader_qos)) {
     // error string was set within the function
     goto fail;
   }
+  // messages delivered in process would bypass the filter and the history per instance
+  if (!filter_expression && !keyed &&
+    !IntraProcessTopic::get(
+      node_info->context, participant, topic_str, type_name, intra_process_topic))
+  {
+    // error string was set within the function
+    goto fail;
+  }
+  // the queue of the messages delivered in process drops the oldest one when it is full,
+  // which only a keep last history does, keep all subscriptions receive through Connext
+  if (datareader_qos.history.kind != DDS::KEEP_LAST_HISTORY_QOS) {
+    intra_process_topic.reset();
+  }
+
+  if (filter_expression) {
+    size_t parameter_count = filter_parameters ? filter_parameters->size : 0;
+    if (parameter_count > static_cast<size_t>((std::numeric_limits<DDS::Long>::max)()) ||
+      !parameters.ensure_length(
+        static_cast<DDS::Long>(parameter_count), static_cast<DDS::Long>(parameter_count)))
+    {
+      RMW_SET_ERROR_MSG("failed to allocate content filter parameters");
+      goto fail;
+    }
+    for (size_t i = 0; i < parameter_count; ++i) {
+      parameters[static_cast<DDS::Long>(i)] = DDS::String_dup(filter_parameters->data[i]);
+    }
+    // the name of a content filtered topic has to be unique within the participant
+    static std::atomic<uint64_t> content_filtered_topic_count(0);
+    std::string content_filtered_topic_name = std::string(topic_str) + "/filtered_" +
+      std::to_string(++content_filtered_topic_count);
+    content_filtered_topic = participant->create_contentfilteredtopic(
+      content_filtered_topic_name.c_str(), topic, filter_expression, parameters);
+    if (!content_filtered_topic) {
+      RMW_SET_ERROR_MSG("failed to create content filtered topic");
+      goto fail;
+    }
+    topic_description = content_filtered_topic;
+  } else {
+    topic_description = topic;
+  }
+  DDS::String_free(topic_str);
+  topic_str = nullptr;
 
   topic_reader = dds_subscriber->create_datareader(
-    topic, datareader_qos,
+    topic_description, datareader_qos,
     NULL, DDS::STATUS_MASK_NONE);
   if (!topic_reader) {
     RMW_SET_ERROR_MSG("failed to create datareader");
@@ -226,6 +271,14 @@ rmw_create_subscription(
     goto fail;
   }
 
+  // The writers of this participant do not match an ignored subscription at all,
+  // only if that fails the samples are checked when taken.
+  if (ignore_local_publications &&
+    participant->ignore_subscription(topic_reader->get_instance_handle()) == DDS::RETCODE_OK)
+  {
+    check_local_publications = false;
+  }
+
   // Allocate memory for the ConnextStaticSubscriberInfo object.
   info_buf = rmw_allocate(sizeof(ConnextStaticSubscriberInfo));
   if (!info_buf) {
@@ -239,9 +292,23 @@ rmw_create_subscription(
   subscriber_info->topic_reader_ = topic_reader;
   subscriber_info->read_condition_ = read_condition;
   subscriber_info->callbacks_ = callbacks;
-  subscriber_info->ignore_local_publications = ignore_local_publications;
+  subscriber_info->ignore_local_publications = check_local_publications;
   subscriber_info->listener_ = subscriber_listener;
   subscriber_listener = nullptr;
+  subscriber_info->content_filtered_topic_ = content_filtered_topic;
+  content_filtered_topic = nullptr;
+  if (intra_process_topic) {
+    intra_process_buf = rmw_allocate(sizeof(IntraProcessSubscription));
+    if (!intra_process_buf) {
+      RMW_SET_ERROR_MSG("failed to allocate memory for intra process subscription");
+      goto fail;
+    }
+    RMW_TRY_PLACEMENT_NEW(
+      subscriber_info->intra_process_, intra_process_buf, goto fail, IntraProcessSubscription,
+      intra_process_topic, topic_reader, datareader_qos, ignore_local_publications)
+    intra_process_buf = nullptr;
+    subscriber_info->intra_process_condition_ = subscriber_info->intra_process_->get_condition();
+  }
 
   subscription->implementation_identifier = rti_connext_identifier;
   subscription->data = subscriber_info;
@@ -255,8 +322,8 @@ rmw_create_subscription(
   memcpy(const_cast<char *>(subscription->topic_name), topic_name, strlen(topic_name) + 1);
 
   if (!qos_profile->avoid_ros_namespace_conventions) {
-    mangled_name =
-      topic_reader->get_topicdescription()->get_name();
+    // the name of the topic, not the one of a content filtered topic
+    mangled_name = topic->get_name();
   } else {
     mangled_name = topic_name;
   }
@@ -285,6 +352,12 @@ fail:
   if (subscription) {
     rmw_subscription_free(subscription);
   }
+  if (subscriber_info && subscriber_info->intra_process_) {
+    RMW_TRY_DESTRUCTOR_FROM_WITHIN_FAILURE(
+      subscriber_info->intra_process_->~IntraProcessSubscription(), IntraProcessSubscription)
+    rmw_free(subscriber_info->intra_process_);
+    subscriber_info->intra_process_ = nullptr;
+  }
   // Assumption: participant is valid.
   if (dds_subscriber) {
     if (topic_reader) {
@@ -310,6 +383,20 @@ fail:
       (std::cerr << ss.str()).flush();
     }
   }
+  if (subscriber_info && subscriber_info->content_filtered_topic_) {
+    content_filtered_topic = subscriber_info->content_filtered_topic_;
+  }
+  if (content_filtered_topic) {
+    if (participant->delete_contentfilteredtopic(content_filtered_topic) != DDS::RETCODE_OK) {
+      std::stringstream ss;
+      ss << "leaking content filtered topic while handling failure at " <<
+        __FILE__ << ":" << __LINE__ << '\n';
+      (std::cerr << ss.str()).flush();
+    }
+  }
+  if (type_registered) {
+    _unregister_serialized_data_type(node_info, type_name);
+  }
   if (subscriber_listener) {
     RMW_TRY_DESTRUCTOR_FROM_WITHIN_FAILURE(
       subscriber_listener->~ConnextSubscriberListener(), ConnextSubscriberListener)
@@ -331,10 +418,25 @@ fail:
   if (listener_buf) {
     rmw_free(listener_buf);
   }
+  if (intra_process_buf) {
+    rmw_free(intra_process_buf);
+  }
 
   return NULL;
 }
 
+rmw_subscription_t *
+rmw_create_subscription(
+  const rmw_node_t * node,
+  const rosidl_message_type_support_t * type_supports,
+  const char * topic_name,
+  const rmw_qos_profile_t * qos_profile,
+  bool ignore_local_publications)
+{
+  return _create_subscription(
+    node, type_supports, topic_name, qos_profile, ignore_local_publications, nullptr, nullptr);
+}
+
 rmw_ret_t
 rmw_subscription_count_matched_publishers(
   const rmw_subscription_t * subscription,
@@ -404,6 +506,22 @@ rmw_destroy_subscription(rmw_node_t * node, rmw_subscription_t * subscription)
     node_info->subscriber_listener->remove_information(
       subscriber_info->dds_subscriber_->get_instance_handle(), EntityType::Subscriber);
     node_info->subscriber_listener->trigger_graph_guard_condition();
+    // outstanding loans have to be returned before the datareader is deleted
+    if (subscriber_info->loan_pool_) {
+      RMW_TRY_DESTRUCTOR(
+        subscriber_info->loan_pool_->~SubscriptionLoanPool(),
+        SubscriptionLoanPool, result = RMW_RET_ERROR)
+      rmw_free(subscriber_info->loan_pool_);
+      subscriber_info->loan_pool_ = nullptr;
+    }
+    if (subscriber_info->intra_process_) {
+      RMW_TRY_DESTRUCTOR(
+        subscriber_info->intra_process_->~IntraProcessSubscription(),
+        IntraProcessSubscription, result = RMW_RET_ERROR)
+      rmw_free(subscriber_info->intra_process_);
+      subscriber_info->intra_process_ = nullptr;
+      subscriber_info->intra_process_condition_ = nullptr;
+    }
     auto dds_subscriber = subscriber_info->dds_subscriber_;
     if (dds_subscriber) {
       auto topic_reader = subscriber_info->topic_reader_;
@@ -434,6 +552,17 @@ rmw_destroy_subscription(rmw_node_t * node, rmw_subscription_t * subscription)
       RMW_SET_ERROR_MSG("cannot delete datareader because the subscriber is null");
       result = RMW_RET_ERROR;
     }
+    // the content filtered topic can only be deleted after its datareader
+    auto content_filtered_topic = subscriber_info->content_filtered_topic_;
+    if (content_filtered_topic && !subscriber_info->topic_reader_) {
+      if (participant->delete_contentfilteredtopic(content_filtered_topic) != DDS::RETCODE_OK) {
+        RMW_SET_ERROR_MSG("failed to delete content filtered topic");
+        result = RMW_RET_ERROR;
+      }
+      subscriber_info->content_filtered_topic_ = nullptr;
+    }
+    _unregister_serialized_data_type(
+      node_info, _create_type_name(subscriber_info->callbacks_, "msg"));
     RMW_TRY_DESTRUCTOR(
       subscriber_info->~ConnextStaticSubscriberInfo(),
       ConnextStaticSubscriberInfo, result = RMW_RET_ERROR)
@@ -448,3 +577,27 @@ rmw_destroy_subscription(rmw_node_t * node, rmw_subscription_t * subscription)
   return result;
 }
 }  // extern "C"
+
+namespace rmw_connext_cpp
+{
+
+rmw_subscription_t *
+create_content_filtered_subscription(
+  const rmw_node_t * node,
+  const rosidl_message_type_support_t * type_supports,
+  const char * topic_name,
+  const rmw_qos_profile_t * qos_profile,
+  bool ignore_local_publications,
+  const char * filter_expression,
+  const rcutils_string_array_t * filter_parameters)
+{
+  if (!filter_expression) {
+    RMW_SET_ERROR_MSG("filter expression is null");
+    return nullptr;
+  }
+  return _create_subscription(
+    node, type_supports, topic_name, qos_profile, ignore_local_publications,
+    filter_expression, filter_parameters);
+}
+
+}  // namespace rmw_connext_cpp
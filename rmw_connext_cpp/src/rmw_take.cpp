@@ -12,39 +12,49 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
+#include <cstring>
 #include <limits>
 
 #include "rmw/error_handling.h"
 #include "rmw/impl/cpp/macros.hpp"
+#include "rmw/serialized_message.h"
 #include "rmw/types.h"
 
+#include "rmw_connext_shared_cpp/message_info.hpp"
+#include "rmw_connext_shared_cpp/trace.hpp"
 #include "rmw_connext_shared_cpp/types.hpp"
 
 #include "rmw_connext_cpp/connext_static_subscriber_info.hpp"
+#include "rmw_connext_cpp/extended_message_info.hpp"
 #include "rmw_connext_cpp/identifier.hpp"
 
+#include "ignore_sample.hpp"
+#include "intra_process.hpp"
+#include "serialized_data.hpp"
+
 // include patched generated code from the build folder
 #include "./connext_static_serialized_dataSupport.h"
 #include "./connext_static_serialized_data.h"
 
+// Take a sample and hand its serialized data to `process` while it is loaned from the
+// datareader, so that it is deserialized or copied without an intermediate buffer.
+template<typename ProcessT>
 static bool
 take(
   DDS::DataReader * dds_data_reader,
   bool ignore_local_publications,
-  rcutils_uint8_array_t * cdr_stream,
+  const IntraProcessSubscription * intra_process,
   bool * taken,
-  void * sending_publication_handle,
-  rmw_subscription_allocation_t * allocation)
+  ConnextMessageInfo * message_info,
+  rmw_subscription_allocation_t * allocation,
+  ProcessT process)
 {
   (void) allocation;
   if (!dds_data_reader) {
     RMW_SET_ERROR_MSG("dds_data_reader is null");
     return false;
   }
-  if (!cdr_stream) {
-    RMW_SET_ERROR_MSG("cdr stream handle is null");
-    return false;
-  }
   if (!taken) {
     RMW_SET_ERROR_MSG("taken handle is null");
     return false;
@@ -59,8 +69,8 @@ take(
 
   ConnextStaticSerializedDataSeq dds_messages;
   DDS::SampleInfoSeq sample_infos;
-  bool ignore_sample = false;
 
+  RMW_CONNEXT_TRACEPOINT(take_entry, dds_data_reader->get_instance_handle().keyHash.value);
   DDS::ReturnCode_t status = data_reader->take(
     dds_messages,
     sample_infos,
@@ -71,6 +81,9 @@ take(
   if (status == DDS::RETCODE_NO_DATA) {
     data_reader->return_loan(dds_messages, sample_infos);
     *taken = false;
+    // without a sample there is no publication GID and sequence number
+    RMW_CONNEXT_TRACEPOINT(
+      take_exit, dds_data_reader->get_instance_handle().keyHash.value, 0, 0);
     return true;
   }
   if (status != DDS::RETCODE_OK) {
@@ -80,53 +93,74 @@ take(
   }
 
   DDS::SampleInfo & sample_info = sample_infos[0];
-  if (!sample_info.valid_data) {
-    // skip sample without data
-    ignore_sample = true;
-  } else if (ignore_local_publications) {
-    // compare the lower 12 octets of the guids from the sender and this receiver
-    // if they are equal the sample has been sent from this process and should be ignored
-    DDS::GUID_t sender_guid = sample_info.original_publication_virtual_guid;
-    DDS::InstanceHandle_t receiver_instance_handle = dds_data_reader->get_instance_handle();
-    ignore_sample = true;
-    for (size_t i = 0; i < 12; ++i) {
-      DDS::Octet * sender_element = &(sender_guid.value[i]);
-      DDS::Octet * receiver_element =
-        &(reinterpret_cast<DDS::Octet *>(&receiver_instance_handle)[i]);
-      if (*sender_element != *receiver_element) {
-        ignore_sample = false;
-        break;
-      }
-    }
-  }
-  if (sample_info.valid_data && sending_publication_handle) {
-    *static_cast<DDS::InstanceHandle_t *>(sending_publication_handle) =
-      sample_info.publication_handle;
+  RMW_CONNEXT_TRACEPOINT(
+    take_exit, dds_data_reader->get_instance_handle().keyHash.value,
+    sample_info.publication_handle.keyHash.value,
+    RMW_CONNEXT_TRACE_SEQUENCE_NUMBER(sample_info.publication_sequence_number));
+  bool ignore_sample = _ignore_sample(
+    dds_data_reader, sample_info, ignore_local_publications, intra_process);
+  if (sample_info.valid_data && message_info) {
+    set_message_info(rti_connext_identifier, sample_info, *message_info);
   }
 
+  *taken = false;
   if (!ignore_sample) {
-    cdr_stream->buffer_length = dds_messages[0].serialized_data.length();
-    // TODO(karsten1987): This malloc has to go!
-    cdr_stream->buffer =
-      reinterpret_cast<uint8_t *>(malloc(cdr_stream->buffer_length * sizeof(uint8_t)));
-
-    if (cdr_stream->buffer_length > (std::numeric_limits<unsigned int>::max)()) {
+    DDS::OctetSeq & serialized_data = dds_messages[0].serialized_data;
+    if (static_cast<size_t>(serialized_data.length()) >
+      (std::numeric_limits<unsigned int>::max)())
+    {
       RMW_SET_ERROR_MSG("cdr_stream->buffer_length unexpectedly larger than max unsiged int value");
       data_reader->return_loan(dds_messages, sample_infos);
-      *taken = false;
       return false;
     }
-    for (unsigned int i = 0; i < static_cast<unsigned int>(cdr_stream->buffer_length); ++i) {
-      cdr_stream->buffer[i] = dds_messages[0].serialized_data[i];
+    rcutils_uint8_array_t cdr_stream = rcutils_get_zero_initialized_uint8_array();
+    cdr_stream.buffer = reinterpret_cast<uint8_t *>(serialized_data.get_contiguous_buffer());
+    cdr_stream.buffer_length = serialized_data.length();
+    cdr_stream.buffer_capacity = serialized_data.length();
+    if (!process(cdr_stream)) {
+      // the error is set by process
+      data_reader->return_loan(dds_messages, sample_infos);
+      return false;
     }
     *taken = true;
-  } else {
-    *taken = false;
   }
 
   data_reader->return_loan(dds_messages, sample_infos);
 
-  return status == DDS::RETCODE_OK;
+  return true;
+}
+
+bool
+_copy_to_serialized_message(
+  const uint8_t * buffer,
+  size_t buffer_length,
+  rmw_serialized_message_t * serialized_message)
+{
+  if (serialized_message->buffer_capacity < buffer_length) {
+    if (rmw_serialized_message_resize(serialized_message, buffer_length) != RMW_RET_OK) {
+      // the error is set by the resize
+      return false;
+    }
+  }
+  if (buffer_length > 0) {
+    memcpy(serialized_message->buffer, buffer, buffer_length);
+  }
+  serialized_message->buffer_length = buffer_length;
+  return true;
+}
+
+static void
+set_intra_process_message_info(
+  const IntraProcessMessage & intra_process_message,
+  ConnextMessageInfo & message_info)
+{
+  set_publisher_gid(
+    rti_connext_identifier, intra_process_message.publication_handle,
+    message_info.publisher_gid);
+  message_info.source_timestamp = intra_process_message.source_timestamp;
+  message_info.reception_timestamp = intra_process_message.reception_timestamp;
+  message_info.publication_sequence_number = intra_process_message.sequence_number;
+  message_info.original_publication_sequence_number = intra_process_message.sequence_number;
 }
 
 extern "C"
@@ -136,7 +170,7 @@ _take(
   const rmw_subscription_t * subscription,
   void * ros_message,
   bool * taken,
-  DDS::InstanceHandle_t * sending_publication_handle,
+  ConnextMessageInfo * message_info,
   rmw_subscription_allocation_t * allocation)
 {
   if (!subscription) {
@@ -174,25 +208,54 @@ _take(
     return RMW_RET_ERROR;
   }
 
-  // fetch the incoming message as cdr stream
-  rcutils_uint8_array_t cdr_stream = rcutils_get_zero_initialized_uint8_array();
+  IntraProcessSubscription * intra_process = subscriber_info->intra_process_;
+  IntraProcessMessage intra_process_message;
+  if (intra_process && intra_process->take(intra_process_message)) {
+    // deserialize directly from the buffer shared by the local publisher
+    rcutils_uint8_array_t cdr_stream = rcutils_get_zero_initialized_uint8_array();
+    cdr_stream.buffer = const_cast<uint8_t *>(intra_process_message.buffer.get());
+    cdr_stream.buffer_length = intra_process_message.buffer_length;
+    cdr_stream.buffer_capacity = intra_process_message.buffer_length;
+    auto deserialize_start = std::chrono::steady_clock::now();
+    RMW_CONNEXT_TRACEPOINT(to_message_entry, topic_reader->get_instance_handle().keyHash.value);
+    if (!callbacks->to_message(&cdr_stream, ros_message)) {
+      RMW_SET_ERROR_MSG("can't convert cdr stream to ros message");
+      return RMW_RET_ERROR;
+    }
+    RMW_CONNEXT_TRACEPOINT(to_message_exit, topic_reader->get_instance_handle().keyHash.value);
+    subscriber_info->deserialize_time_.record(
+      std::chrono::steady_clock::now() - deserialize_start);
+    if (message_info) {
+      set_intra_process_message_info(intra_process_message, *message_info);
+    }
+    *taken = true;
+    return RMW_RET_OK;
+  }
+
+  // deserialize the incoming message directly from the sample loaned by the datareader
+  auto to_message = [&](const rcutils_uint8_array_t & cdr_stream) -> bool
+    {
+      auto deserialize_start = std::chrono::steady_clock::now();
+      RMW_CONNEXT_TRACEPOINT(
+        to_message_entry, topic_reader->get_instance_handle().keyHash.value);
+      if (!callbacks->to_message(&cdr_stream, ros_message)) {
+        RMW_SET_ERROR_MSG("can't convert cdr stream to ros message");
+        return false;
+      }
+      RMW_CONNEXT_TRACEPOINT(
+        to_message_exit, topic_reader->get_instance_handle().keyHash.value);
+      subscriber_info->deserialize_time_.record(
+        std::chrono::steady_clock::now() - deserialize_start);
+      return true;
+    };
   if (!take(
-      topic_reader, subscriber_info->ignore_local_publications, &cdr_stream, taken,
-      sending_publication_handle, allocation))
+      topic_reader, subscriber_info->ignore_local_publications, intra_process, taken,
+      message_info, allocation, to_message))
   {
-    RMW_SET_ERROR_MSG("error occured while taking message");
-    return RMW_RET_ERROR;
-  }
-  // convert the cdr stream to the message
-  if (*taken && !callbacks->to_message(&cdr_stream, ros_message)) {
-    RMW_SET_ERROR_MSG("can't convert cdr stream to ros message");
+    // Error string is already set.
     return RMW_RET_ERROR;
   }
 
-  // the call to take allocates memory for the serialized message
-  // we have to free this here again
-  free(cdr_stream.buffer);
-
   return RMW_RET_OK;
 }
 
@@ -218,18 +281,15 @@ rmw_take_with_info(
     RMW_SET_ERROR_MSG("message info is null");
     return RMW_RET_ERROR;
   }
-  DDS::InstanceHandle_t sending_publication_handle;
-  auto ret = _take(subscription, ros_message, taken, &sending_publication_handle, allocation);
+  ConnextMessageInfo connext_message_info;
+  auto ret = _take(subscription, ros_message, taken, &connext_message_info, allocation);
   if (ret != RMW_RET_OK) {
     // Error string is already set.
     return RMW_RET_ERROR;
   }
-
-  rmw_gid_t * sender_gid = &message_info->publisher_gid;
-  sender_gid->implementation_identifier = rti_connext_identifier;
-  memset(sender_gid->data, 0, RMW_GID_STORAGE_SIZE);
-  auto detail = reinterpret_cast<ConnextPublisherGID *>(sender_gid->data);
-  detail->publication_handle = sending_publication_handle;
+  if (*taken) {
+    message_info->publisher_gid = connext_message_info.publisher_gid;
+  }
 
   return RMW_RET_OK;
 }
@@ -239,7 +299,7 @@ _take_serialized_message(
   const rmw_subscription_t * subscription,
   rmw_serialized_message_t * serialized_message,
   bool * taken,
-  DDS::InstanceHandle_t * sending_publication_handle,
+  ConnextMessageInfo * message_info,
   rmw_subscription_allocation_t * allocation)
 {
   if (!subscription) {
@@ -277,12 +337,34 @@ _take_serialized_message(
     return RMW_RET_ERROR;
   }
 
-  // fetch the incoming message as cdr stream
+  IntraProcessSubscription * intra_process = subscriber_info->intra_process_;
+  IntraProcessMessage intra_process_message;
+  if (intra_process && intra_process->take(intra_process_message)) {
+    // the buffer is shared with other subscriptions, the serialized message needs a copy
+    if (!_copy_to_serialized_message(
+        intra_process_message.buffer.get(), intra_process_message.buffer_length,
+        serialized_message))
+    {
+      return RMW_RET_ERROR;
+    }
+    if (message_info) {
+      set_intra_process_message_info(intra_process_message, *message_info);
+    }
+    *taken = true;
+    return RMW_RET_OK;
+  }
+
+  // copy the incoming message from the sample loaned by the datareader
+  auto copy = [serialized_message](const rcutils_uint8_array_t & cdr_stream) -> bool
+    {
+      return _copy_to_serialized_message(
+        cdr_stream.buffer, cdr_stream.buffer_length, serialized_message);
+    };
   if (!take(
-      topic_reader, subscriber_info->ignore_local_publications, serialized_message, taken,
-      sending_publication_handle, allocation))
+      topic_reader, subscriber_info->ignore_local_publications, intra_process, taken,
+      message_info, allocation, copy))
   {
-    RMW_SET_ERROR_MSG("error occured while taking message");
+    // Error string is already set.
     return RMW_RET_ERROR;
   }
 
@@ -311,21 +393,45 @@ rmw_take_serialized_message_with_info(
     RMW_SET_ERROR_MSG("message info is null");
     return RMW_RET_ERROR;
   }
-  DDS::InstanceHandle_t sending_publication_handle;
+  ConnextMessageInfo connext_message_info;
   auto ret =
     _take_serialized_message(subscription, serialized_message, taken,
-      &sending_publication_handle, allocation);
+      &connext_message_info, allocation);
   if (ret != RMW_RET_OK) {
     // Error string is already set.
     return RMW_RET_ERROR;
   }
-
-  rmw_gid_t * sender_gid = &message_info->publisher_gid;
-  sender_gid->implementation_identifier = rti_connext_identifier;
-  memset(sender_gid->data, 0, RMW_GID_STORAGE_SIZE);
-  auto detail = reinterpret_cast<ConnextPublisherGID *>(sender_gid->data);
-  detail->publication_handle = sending_publication_handle;
+  if (*taken) {
+    message_info->publisher_gid = connext_message_info.publisher_gid;
+  }
 
   return RMW_RET_OK;
 }
 }  // extern "C"
+
+namespace rmw_connext_cpp
+{
+
+rmw_ret_t
+take_with_extended_info(
+  const rmw_subscription_t * subscription,
+  void * ros_message,
+  bool * taken,
+  ConnextMessageInfo * message_info)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(message_info, RMW_RET_INVALID_ARGUMENT);
+  return _take(subscription, ros_message, taken, message_info, nullptr);
+}
+
+rmw_ret_t
+take_serialized_message_with_extended_info(
+  const rmw_subscription_t * subscription,
+  rmw_serialized_message_t * serialized_message,
+  bool * taken,
+  ConnextMessageInfo * message_info)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(message_info, RMW_RET_INVALID_ARGUMENT);
+  return _take_serialized_message(subscription, serialized_message, taken, message_info, nullptr);
+}
+
+}  // namespace rmw_connext_cpp
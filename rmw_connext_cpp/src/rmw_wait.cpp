@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdint>
+
 #include "rmw/rmw.h"
 
 #include "rmw_connext_shared_cpp/wait.hpp"
@@ -21,6 +23,8 @@
 #include "rmw_connext_cpp/connext_static_service_info.hpp"
 #include "rmw_connext_cpp/connext_static_subscriber_info.hpp"
 
+#include "in_flight_requests.hpp"
+
 extern "C"
 {
 rmw_ret_t
@@ -32,8 +36,24 @@ rmw_wait(
   rmw_wait_set_t * wait_set,
   const rmw_time_t * wait_timeout)
 {
+  // expire the requests of clients with a request window and find their next deadline
+  auto expire_requests = [](rmw_clients_t * clients) -> int64_t
+    {
+      int64_t next_deadline_ns = -1;
+      for (size_t i = 0; clients && i < clients->client_count; ++i) {
+        auto client_info = static_cast<ConnextStaticClientInfo *>(clients->clients[i]);
+        if (!client_info || !client_info->in_flight_) {
+          continue;
+        }
+        int64_t deadline_ns = client_info->in_flight_->expire();
+        if (deadline_ns >= 0 && (next_deadline_ns < 0 || deadline_ns < next_deadline_ns)) {
+          next_deadline_ns = deadline_ns;
+        }
+      }
+      return next_deadline_ns;
+    };
   return wait<ConnextStaticSubscriberInfo, ConnextStaticServiceInfo, ConnextStaticClientInfo>(
     rti_connext_identifier, subscriptions, guard_conditions, services, clients, wait_set,
-    wait_timeout);
+    wait_timeout, expire_requests);
 }
 }  // extern "C"
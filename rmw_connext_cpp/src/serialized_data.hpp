@@ -0,0 +1,52 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef SERIALIZED_DATA_HPP_
+#define SERIALIZED_DATA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rcutils/types/uint8_array.h"
+
+#include "rmw/serialized_message.h"
+
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+
+/// Write serialized data as a sample of the serialized data type.
+/**
+ * The data is loaned to the sample, not copied.
+ *
+ * \param[in] key_hash instance of the sample, `NULL` for topics without key
+ * \param[inout] write_params identities of the sample, set to the assigned ones when written
+ * \return status of the write, `DDS::RETCODE_TIMEOUT` if the datawriter queue stayed full,
+ *   or `DDS::RETCODE_ERROR` with the error set if the sample could not be prepared
+ */
+DDS::ReturnCode_t
+_write_serialized_data(
+  DDS::DataWriter * dds_data_writer,
+  const rcutils_uint8_array_t * cdr_stream,
+  const DDS::Octet * key_hash,
+  DDS_WriteParams_t & write_params);
+
+/// Copy serialized data into a serialized message, growing its buffer only if it is too small.
+/**
+ * \return false if the buffer could not be grown, the error is set
+ */
+bool
+_copy_to_serialized_message(
+  const uint8_t * buffer,
+  size_t buffer_length,
+  rmw_serialized_message_t * serialized_message);
+
+#endif  // SERIALIZED_DATA_HPP_
@@ -0,0 +1,909 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "rmw/error_handling.h"
+#include "rmw/impl/cpp/macros.hpp"
+#include "rmw/rmw.h"
+
+#include "rmw_connext_shared_cpp/trace.hpp"
+
+#include "rmw_connext_cpp/connext_static_client_info.hpp"
+#include "rmw_connext_cpp/connext_static_service_info.hpp"
+#include "rmw_connext_cpp/identifier.hpp"
+#include "rmw_connext_cpp/serialized_service.hpp"
+
+#include "in_flight_requests.hpp"
+#include "serialized_data.hpp"
+#include "serialized_service.hpp"
+#include "shared_requester.hpp"
+#include "type_support_common.hpp"
+
+// include patched generated code from the build folder
+#include "connext_static_serialized_dataSupport.h"
+
+// Content filter of the replies to the requests of one datawriter, see _register_reply_filter().
+#define RMW_CONNEXT_REPLY_FILTER_NAME "RMW_CONNEXT_REPLY_FILTER"
+
+// Passes the samples whose related sample identity has the writer GUID given as parameter,
+// in hexadecimal. It only looks at the meta data of the samples, so the types need no type
+// code, which the serialized request and reply types do not have.
+class ReplyFilter : public DDSContentFilter
+{
+public:
+  virtual DDS_ReturnCode_t
+  compile(
+    void ** new_compile_data,
+    const char *,
+    const DDS_StringSeq & parameters,
+    const DDS_TypeCode *,
+    const char *,
+    void * old_compile_data)
+  {
+    DDS_GUID_t guid;
+    if (parameters.length() != 1 || !_parse_guid(parameters[0], guid)) {
+      return DDS_RETCODE_BAD_PARAMETER;
+    }
+    DDS_GUID_t * compiled_guid = static_cast<DDS_GUID_t *>(old_compile_data);
+    if (!compiled_guid) {
+      compiled_guid = new (std::nothrow) DDS_GUID_t;
+      if (!compiled_guid) {
+        return DDS_RETCODE_OUT_OF_RESOURCES;
+      }
+    }
+    *compiled_guid = guid;
+    *new_compile_data = compiled_guid;
+    return DDS_RETCODE_OK;
+  }
+
+  virtual DDS_Boolean
+  evaluate(void * compile_data, const void *, const struct DDS_FilterSampleInfo * meta_data)
+  {
+    const DDS_GUID_t * guid = static_cast<const DDS_GUID_t *>(compile_data);
+    return memcmp(
+      meta_data->related_sample_identity.writer_guid.value, guid->value,
+      sizeof(guid->value)) == 0 ? DDS_BOOLEAN_TRUE : DDS_BOOLEAN_FALSE;
+  }
+
+  virtual void
+  finalize(void * compile_data)
+  {
+    delete static_cast<DDS_GUID_t *>(compile_data);
+  }
+
+private:
+  static bool
+  _parse_guid(const char * hex, DDS_GUID_t & guid)
+  {
+    if (!hex || strlen(hex) != 2 * sizeof(guid.value)) {
+      return false;
+    }
+    for (size_t i = 0; i < sizeof(guid.value); ++i) {
+      int high = _parse_hex_digit(hex[2 * i]);
+      int low = _parse_hex_digit(hex[2 * i + 1]);
+      if (high < 0 || low < 0) {
+        return false;
+      }
+      guid.value[i] = static_cast<DDS::Octet>(high << 4 | low);
+    }
+    return true;
+  }
+
+  static int
+  _parse_hex_digit(char digit)
+  {
+    if (digit >= '0' && digit <= '9') {
+      return digit - '0';
+    }
+    if (digit >= 'a' && digit <= 'f') {
+      return digit - 'a' + 10;
+    }
+    return -1;
+  }
+};
+
+bool
+_register_reply_filter(DDS::DomainParticipant * participant)
+{
+  // the filter is stateless, the compiled writer GUIDs are owned by the content filters
+  static ReplyFilter reply_filter;
+  static std::mutex register_mutex;
+  std::lock_guard<std::mutex> lock(register_mutex);
+  if (participant->lookup_contentfilter(RMW_CONNEXT_REPLY_FILTER_NAME)) {
+    return true;
+  }
+  if (participant->register_contentfilter(
+      RMW_CONNEXT_REPLY_FILTER_NAME, &reply_filter) != DDS::RETCODE_OK)
+  {
+    RMW_SET_ERROR_MSG("failed to register reply filter");
+    return false;
+  }
+  return true;
+}
+
+// Types registered by the serialized clients and services of a node have an entry without
+// endpoint count in the registered types of the node, they stay registered with the node.
+static bool
+_register_serialized_service_type(ConnextNodeInfo * node_info, const std::string & type_name)
+{
+  if (node_info->keyed_types.count(type_name)) {
+    return true;
+  }
+  // Connext keeps the first plugin registered for a type name, the one of a typed requester
+  // or replier can not take serialized samples
+  if (node_info->participant->is_type_registered(type_name.c_str())) {
+    std::string error_msg = "service type '" + type_name +
+      "' is used by a typed client or service of the node, serialized clients and services " +
+      "of the node can not use it";
+    RMW_SET_ERROR_MSG(error_msg.c_str());
+    return false;
+  }
+  // The typed samples have no type code in the service type support, without one the
+  // serialized data type is matched with them by name.
+  if (ConnextStaticSerializedDataSupport_register_external_type_by_name(
+      node_info->participant, type_name.c_str()) != DDS::RETCODE_OK)
+  {
+    RMW_SET_ERROR_MSG("failed to register external type");
+    return false;
+  }
+  ConnextRegisteredType & registered_type = node_info->keyed_types[type_name];
+  registered_type.keyed = false;
+  registered_type.endpoint_count = 0;
+  return true;
+}
+
+bool
+_register_serialized_service_types(
+  ConnextNodeInfo * node_info,
+  const service_type_support_callbacks_t * callbacks)
+{
+  std::lock_guard<std::mutex> lock(node_info->keyed_types_mutex);
+  return _register_serialized_service_type(node_info, _create_type_name(callbacks, "Request")) &&
+         _register_serialized_service_type(node_info, _create_type_name(callbacks, "Response"));
+}
+
+bool
+_check_typed_service_types(
+  ConnextNodeInfo * node_info,
+  const service_type_support_callbacks_t * callbacks)
+{
+  std::lock_guard<std::mutex> lock(node_info->keyed_types_mutex);
+  for (const char * suffix : {"Request", "Response"}) {
+    std::string type_name = _create_type_name(callbacks, suffix);
+    if (node_info->keyed_types.count(type_name)) {
+      std::string error_msg = "service type '" + type_name +
+        "' is used by a serialized client or service of the node, typed clients and " +
+        "services of the node can not use it";
+      RMW_SET_ERROR_MSG(error_msg.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+// Find the topic of the requests or replies of a service, or create it.
+// The type has to be registered by _register_serialized_service_types() before.
+static DDS::Topic *
+_find_or_create_topic(
+  DDS::DomainParticipant * participant,
+  const char * topic_str,
+  const std::string & type_name)
+{
+  DDS::ReturnCode_t status = DDS::RETCODE_ERROR;
+  DDS::Topic * topic = nullptr;
+  if (!participant->lookup_topicdescription(topic_str)) {
+    DDS::TopicQos default_topic_qos;
+    status = participant->get_default_topic_qos(default_topic_qos);
+    if (status != DDS::RETCODE_OK) {
+      RMW_SET_ERROR_MSG("failed to get default topic qos");
+      return nullptr;
+    }
+    topic = participant->create_topic(
+      topic_str, type_name.c_str(), default_topic_qos, NULL, DDS::STATUS_MASK_NONE);
+    if (!topic) {
+      RMW_SET_ERROR_MSG("failed to create topic");
+    }
+  } else {
+    DDS::Duration_t timeout = DDS::Duration_t::from_seconds(0);
+    topic = participant->find_topic(topic_str, timeout);
+    if (!topic) {
+      RMW_SET_ERROR_MSG("failed to find topic");
+    }
+  }
+  return topic;
+}
+
+static DDS::DataWriter *
+_create_datawriter(
+  DDS::DomainParticipant * participant,
+  DDS::Topic * topic,
+  const DDS::DataWriterQos & datawriter_qos)
+{
+  DDS::PublisherQos publisher_qos;
+  if (participant->get_default_publisher_qos(publisher_qos) != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to get default publisher qos");
+    return nullptr;
+  }
+  DDS::Publisher * dds_publisher = participant->create_publisher(
+    publisher_qos, NULL, DDS::STATUS_MASK_NONE);
+  if (!dds_publisher) {
+    RMW_SET_ERROR_MSG("failed to create publisher");
+    return nullptr;
+  }
+  DDS::DataWriter * datawriter = dds_publisher->create_datawriter(
+    topic, datawriter_qos, NULL, DDS::STATUS_MASK_NONE);
+  if (!datawriter) {
+    RMW_SET_ERROR_MSG("failed to create datawriter");
+    participant->delete_publisher(dds_publisher);
+  }
+  return datawriter;
+}
+
+// Create a datareader in a subscriber of its own, in the given partition if any.
+static DDS::DataReader *
+_create_datareader(
+  DDS::DomainParticipant * participant,
+  DDS::TopicDescription * topic,
+  const DDS::DataReaderQos & datareader_qos,
+  const char * partition = nullptr)
+{
+  DDS::SubscriberQos subscriber_qos;
+  if (participant->get_default_subscriber_qos(subscriber_qos) != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to get default subscriber qos");
+    return nullptr;
+  }
+  if (partition && *partition) {
+    if (!subscriber_qos.partition.name.ensure_length(1, 1)) {
+      RMW_SET_ERROR_MSG("failed to set subscriber partition");
+      return nullptr;
+    }
+    DDS::String_free(subscriber_qos.partition.name[0]);
+    subscriber_qos.partition.name[0] = DDS::String_dup(partition);
+  }
+  DDS::Subscriber * dds_subscriber = participant->create_subscriber(
+    subscriber_qos, NULL, DDS::STATUS_MASK_NONE);
+  if (!dds_subscriber) {
+    RMW_SET_ERROR_MSG("failed to create subscriber");
+    return nullptr;
+  }
+  DDS::DataReader * datareader = dds_subscriber->create_datareader(
+    topic, datareader_qos, NULL, DDS::STATUS_MASK_NONE);
+  if (!datareader) {
+    RMW_SET_ERROR_MSG("failed to create datareader");
+    participant->delete_subscriber(dds_subscriber);
+  }
+  return datareader;
+}
+
+// Create the content filtered topic passing the replies to the requests of a datawriter.
+static DDS::ContentFilteredTopic *
+_create_reply_filtered_topic(
+  DDS::DomainParticipant * participant,
+  DDS::Topic * reply_topic,
+  DDS::DataWriter * request_datawriter)
+{
+  if (!_register_reply_filter(participant)) {
+    return nullptr;
+  }
+  // the instance handle of an entity is its GUID
+  const DDS::InstanceHandle_t writer_handle = request_datawriter->get_instance_handle();
+  char guid[2 * sizeof(writer_handle.keyHash.value) + 1];
+  for (size_t i = 0; i < sizeof(writer_handle.keyHash.value); ++i) {
+    snprintf(&guid[2 * i], 3, "%02x", writer_handle.keyHash.value[i]);
+  }
+  // the name of a content filtered topic has to be unique within the participant
+  std::string topic_name = std::string(reply_topic->get_name()) + "_" + guid;
+  DDS::StringSeq parameters;
+  if (!parameters.ensure_length(1, 1)) {
+    RMW_SET_ERROR_MSG("failed to set reply filter parameters");
+    return nullptr;
+  }
+  parameters[0] = DDS::String_dup(guid);
+  DDS::ContentFilteredTopic * filtered_topic = participant->create_contentfilteredtopic_with_filter(
+    topic_name.c_str(), reply_topic, "@related_sample_identity.writer_guid = %0", parameters,
+    RMW_CONNEXT_REPLY_FILTER_NAME);
+  if (!filtered_topic) {
+    RMW_SET_ERROR_MSG("failed to create reply filtered topic");
+  }
+  return filtered_topic;
+}
+
+// Create a datareader for one and a datawriter for the other topic of a service.
+// The datareader of a requester only reads the replies to the requests of the datawriter.
+static bool
+_create_serialized_entities(
+  DDS::DomainParticipant * participant,
+  const char * reader_topic_str,
+  const std::string & reader_type_name,
+  const char * writer_topic_str,
+  const std::string & writer_type_name,
+  const DDS::DataReaderQos & datareader_qos,
+  const DDS::DataWriterQos & datawriter_qos,
+  bool filter_replies,
+  DDS::DataReader ** datareader,
+  DDS::DataWriter ** datawriter)
+{
+  DDS::Topic * reader_topic = _find_or_create_topic(
+    participant, reader_topic_str, reader_type_name);
+  if (!reader_topic) {
+    return false;
+  }
+  DDS::Topic * writer_topic = _find_or_create_topic(
+    participant, writer_topic_str, writer_type_name);
+  if (!writer_topic) {
+    return false;
+  }
+  *datawriter = _create_datawriter(participant, writer_topic, datawriter_qos);
+  if (!*datawriter) {
+    return false;
+  }
+  DDS::TopicDescription * reader_topic_description = reader_topic;
+  DDS::ContentFilteredTopic * filtered_topic = nullptr;
+  if (filter_replies) {
+    filtered_topic = _create_reply_filtered_topic(participant, reader_topic, *datawriter);
+    if (!filtered_topic) {
+      _delete_serialized_entities(participant, nullptr, *datawriter);
+      *datawriter = nullptr;
+      return false;
+    }
+    reader_topic_description = filtered_topic;
+  }
+  *datareader = _create_datareader(participant, reader_topic_description, datareader_qos);
+  if (!*datareader) {
+    if (filtered_topic) {
+      participant->delete_contentfilteredtopic(filtered_topic);
+    }
+    _delete_serialized_entities(participant, nullptr, *datawriter);
+    *datawriter = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool
+_create_serialized_requester(
+  DDS::DomainParticipant * participant,
+  const service_type_support_callbacks_t * callbacks,
+  const char * request_topic_str,
+  const char * response_topic_str,
+  const DDS::DataReaderQos & datareader_qos,
+  const DDS::DataWriterQos & datawriter_qos,
+  DDS::DataReader ** response_datareader,
+  DDS::DataWriter ** request_datawriter)
+{
+  return _create_serialized_entities(
+    participant,
+    response_topic_str, _create_type_name(callbacks, "Response"),
+    request_topic_str, _create_type_name(callbacks, "Request"),
+    datareader_qos, datawriter_qos, true, response_datareader, request_datawriter);
+}
+
+bool
+_create_serialized_replier(
+  DDS::DomainParticipant * participant,
+  const service_type_support_callbacks_t * callbacks,
+  const char * request_topic_str,
+  const char * response_topic_str,
+  const DDS::DataReaderQos & datareader_qos,
+  const DDS::DataWriterQos & datawriter_qos,
+  DDS::DataReader ** request_datareader,
+  DDS::DataWriter ** response_datawriter)
+{
+  return _create_serialized_entities(
+    participant,
+    request_topic_str, _create_type_name(callbacks, "Request"),
+    response_topic_str, _create_type_name(callbacks, "Response"),
+    datareader_qos, datawriter_qos, false, request_datareader, response_datawriter);
+}
+
+DDS::DataReader *
+_create_serialized_lane_datareader(
+  DDS::DomainParticipant * participant,
+  DDS::DataReader * request_datareader,
+  const char * partition)
+{
+  DDS::DataReaderQos datareader_qos;
+  if (request_datareader->get_qos(datareader_qos) != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to get datareader qos");
+    return nullptr;
+  }
+  return _create_datareader(
+    participant, request_datareader->get_topicdescription(), datareader_qos, partition);
+}
+
+bool
+_delete_serialized_entities(
+  DDS::DomainParticipant * participant,
+  DDS::DataReader * datareader,
+  DDS::DataWriter * datawriter)
+{
+  bool result = true;
+  if (datareader) {
+    DDS::Subscriber * dds_subscriber = datareader->get_subscriber();
+    // the reply filtered topic of a requester can only be deleted after its datareader
+    DDS::ContentFilteredTopic * filtered_topic =
+      DDS::ContentFilteredTopic::narrow(datareader->get_topicdescription());
+    if (dds_subscriber->delete_datareader(datareader) != DDS::RETCODE_OK ||
+      participant->delete_subscriber(dds_subscriber) != DDS::RETCODE_OK)
+    {
+      RMW_SET_ERROR_MSG("failed to delete datareader");
+      result = false;
+    } else if (filtered_topic &&
+      participant->delete_contentfilteredtopic(filtered_topic) != DDS::RETCODE_OK)
+    {
+      RMW_SET_ERROR_MSG("failed to delete reply filtered topic");
+      result = false;
+    }
+  }
+  if (datawriter) {
+    DDS::Publisher * dds_publisher = datawriter->get_publisher();
+    if (dds_publisher->delete_datawriter(datawriter) != DDS::RETCODE_OK ||
+      participant->delete_publisher(dds_publisher) != DDS::RETCODE_OK)
+    {
+      RMW_SET_ERROR_MSG("failed to delete datawriter");
+      result = false;
+    }
+  }
+  return result;
+}
+
+rmw_ret_t
+_write_serialized_message(
+  DDS::DataWriter * datawriter,
+  const rmw_serialized_message_t * serialized_message,
+  DDS_WriteParams_t & write_params)
+{
+  DDS::ReturnCode_t status =
+    _write_serialized_data(datawriter, serialized_message, nullptr, write_params);
+  if (status == DDS::RETCODE_TIMEOUT) {
+    RMW_SET_ERROR_MSG("datawriter queue is full");
+    return RMW_RET_TIMEOUT;
+  }
+  if (status != DDS::RETCODE_OK) {
+    // a failed loan has set the error already
+    if (!rmw_error_is_set()) {
+      RMW_SET_ERROR_MSG("failed to write serialized message");
+    }
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
+
+// Take up to `count` requests, or replies to requests of `request_writer_guid`.
+// The request headers are set to the identities of the requests.
+// Replies to requests which are no longer in flight are dropped before they are copied.
+static bool
+_take_serialized_messages(
+  DDS::DataReader * dds_data_reader,
+  const DDS::Octet * request_writer_guid,
+  InFlightRequests * in_flight,
+  size_t count,
+  rmw_request_id_t * request_headers,
+  rmw_serialized_message_t * serialized_messages,
+  size_t * taken_count)
+{
+  ConnextStaticSerializedDataDataReader * data_reader =
+    ConnextStaticSerializedDataDataReader::narrow(dds_data_reader);
+  if (!data_reader) {
+    RMW_SET_ERROR_MSG("failed to narrow data reader");
+    return false;
+  }
+
+  const size_t max_long = static_cast<size_t>((std::numeric_limits<DDS::Long>::max)());
+  *taken_count = 0;
+  while (*taken_count < count) {
+    ConnextStaticSerializedDataSeq dds_messages;
+    DDS::SampleInfoSeq sample_infos;
+    DDS::ReturnCode_t status = data_reader->take(
+      dds_messages,
+      sample_infos,
+      static_cast<DDS::Long>((std::min)(count - *taken_count, max_long)),
+      DDS::ANY_SAMPLE_STATE,
+      DDS::ANY_VIEW_STATE,
+      DDS::ANY_INSTANCE_STATE);
+    if (status == DDS::RETCODE_NO_DATA) {
+      return true;
+    }
+    if (status != DDS::RETCODE_OK) {
+      RMW_SET_ERROR_MSG("take failed");
+      return false;
+    }
+
+    bool copied = true;
+    for (DDS::Long i = 0; copied && i < dds_messages.length(); ++i) {
+      const DDS::SampleInfo & sample_info = sample_infos[i];
+      DDS_SampleIdentity_t identity;
+      if (request_writer_guid) {
+        DDS_SampleInfo_get_related_sample_identity(&sample_info, &identity);
+      } else {
+        DDS_SampleInfo_get_sample_identity(&sample_info, &identity);
+      }
+      // the reply filter only passes the replies to the requests of this client
+      if (!sample_info.valid_data) {
+        continue;
+      }
+      int64_t sequence_number = _sequence_number_to_int64(identity.sequence_number);
+      if (in_flight && !in_flight->complete(sequence_number)) {
+        continue;
+      }
+
+      DDS::OctetSeq & serialized_data = dds_messages[i].serialized_data;
+      copied = _copy_to_serialized_message(
+        reinterpret_cast<const uint8_t *>(serialized_data.get_contiguous_buffer()),
+        static_cast<size_t>(serialized_data.length()), &serialized_messages[*taken_count]);
+      if (copied) {
+        rmw_request_id_t & request_header = request_headers[*taken_count];
+        memcpy(
+          request_header.writer_guid, identity.writer_guid.value,
+          sizeof(identity.writer_guid.value));
+        request_header.sequence_number = sequence_number;
+        ++*taken_count;
+      }
+    }
+    data_reader->return_loan(dds_messages, sample_infos);
+    if (!copied) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Take the next request, or the next reply to a request of `request_writer_guid`.
+static bool
+_take_serialized_message(
+  DDS::DataReader * dds_data_reader,
+  const DDS::Octet * request_writer_guid,
+  InFlightRequests * in_flight,
+  rmw_request_id_t * request_header,
+  rmw_serialized_message_t * serialized_message,
+  bool * taken)
+{
+  size_t taken_count = 0;
+  bool result = _take_serialized_messages(
+    dds_data_reader, request_writer_guid, in_flight, 1, request_header, serialized_message,
+    &taken_count);
+  *taken = taken_count > 0;
+  return result;
+}
+
+// Take up to `count` requests from the lanes of a service, in priority order.
+static bool
+_take_serialized_requests(
+  ConnextStaticServiceInfo * service_info,
+  size_t count,
+  rmw_request_id_t * request_headers,
+  rmw_serialized_message_t * requests,
+  size_t * taken_count)
+{
+  *taken_count = 0;
+  const std::vector<DDS::DataReader *> & lane_datareaders = service_info->lane_datareaders_;
+  size_t default_lane = service_info->default_lane_;
+  for (size_t lane = 0; lane <= lane_datareaders.size() && *taken_count < count; ++lane) {
+    DDS::DataReader * datareader = service_info->request_datareader_;
+    if (lane < default_lane) {
+      datareader = lane_datareaders[lane];
+    } else if (lane > default_lane) {
+      datareader = lane_datareaders[lane - 1];
+    }
+    size_t lane_taken_count = 0;
+    if (!_take_serialized_messages(
+        datareader, nullptr, nullptr, count - *taken_count, request_headers + *taken_count,
+        requests + *taken_count, &lane_taken_count))
+    {
+      return false;
+    }
+    *taken_count += lane_taken_count;
+  }
+  return true;
+}
+
+static void
+_record_taken_request(
+  ConnextStaticServiceInfo * service_info,
+  const rmw_request_id_t & request_header)
+{
+  service_info->requests_taken_.fetch_add(1, std::memory_order_relaxed);
+  service_info->request_times_.add(request_header.writer_guid, request_header.sequence_number);
+}
+
+static bool
+_write_serialized_response(
+  const rmw_service_t * service,
+  ConnextStaticServiceInfo * service_info,
+  const rmw_request_id_t * request_header,
+  const rmw_serialized_message_t * response)
+{
+  // the related identity routes the reply to the requester, like for a Connext Replier
+  DDS_WriteParams_t write_params = DDS_WRITEPARAMS_DEFAULT;
+  memcpy(
+    write_params.related_sample_identity.writer_guid.value, request_header->writer_guid,
+    sizeof(write_params.related_sample_identity.writer_guid.value));
+  write_params.related_sample_identity.sequence_number =
+    _int64_to_sequence_number(request_header->sequence_number);
+  RMW_CONNEXT_TRACEPOINT(
+    send_response_entry, service, request_header->writer_guid, request_header->sequence_number);
+  rmw_ret_t ret =
+    _write_serialized_message(service_info->response_datawriter_, response, write_params);
+  if (ret == RMW_RET_TIMEOUT) {
+    // dropped like a typed response, see rmw_send_response()
+    rmw_reset_error();
+  } else if (ret != RMW_RET_OK) {
+    return false;
+  }
+  RMW_CONNEXT_TRACEPOINT(send_response_exit, service, request_header->sequence_number);
+  std::chrono::nanoseconds response_time;
+  if (service_info->request_times_.remove(
+      request_header->writer_guid, request_header->sequence_number, response_time))
+  {
+    if (ret == RMW_RET_OK) {
+      service_info->response_time_.record(response_time);
+    }
+  }
+  if (ret == RMW_RET_TIMEOUT) {
+    service_info->responses_dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+static ConnextStaticClientInfo *
+_get_serialized_client_info(const rmw_client_t * client)
+{
+  if (!client) {
+    RMW_SET_ERROR_MSG("client handle is null");
+    return nullptr;
+  }
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    client handle,
+    client->implementation_identifier, rti_connext_identifier,
+    return nullptr)
+  auto client_info = static_cast<ConnextStaticClientInfo *>(client->data);
+  if (!client_info) {
+    RMW_SET_ERROR_MSG("client info handle is null");
+    return nullptr;
+  }
+  if (!client_info->request_datawriter_) {
+    RMW_SET_ERROR_MSG("client was not created for serialized requests");
+    return nullptr;
+  }
+  return client_info;
+}
+
+static ConnextStaticServiceInfo *
+_get_serialized_service_info(const rmw_service_t * service)
+{
+  if (!service) {
+    RMW_SET_ERROR_MSG("service handle is null");
+    return nullptr;
+  }
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    service handle,
+    service->implementation_identifier, rti_connext_identifier,
+    return nullptr)
+  auto service_info = static_cast<ConnextStaticServiceInfo *>(service->data);
+  if (!service_info) {
+    RMW_SET_ERROR_MSG("service info handle is null");
+    return nullptr;
+  }
+  if (!service_info->response_datawriter_) {
+    RMW_SET_ERROR_MSG("service was not created for serialized requests");
+    return nullptr;
+  }
+  return service_info;
+}
+
+namespace rmw_connext_cpp
+{
+
+rmw_ret_t
+send_request_serialized(
+  const rmw_client_t * client,
+  const rmw_serialized_message_t * request,
+  int64_t * sequence_id)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(request, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(sequence_id, RMW_RET_INVALID_ARGUMENT);
+  ConnextStaticClientInfo * client_info = _get_serialized_client_info(client);
+  if (!client_info) {
+    return RMW_RET_ERROR;
+  }
+
+  InFlightRequests * in_flight = client_info->in_flight_;
+  if (in_flight && !in_flight->reserve()) {
+    RMW_SET_ERROR_MSG("too many requests in flight");
+    return RMW_RET_TIMEOUT;
+  }
+  InFlightReservation reservation(in_flight);
+
+  // the identity of the request is assigned by the datawriter, like for a Connext Requester
+  DDS_WriteParams_t write_params = DDS_WRITEPARAMS_DEFAULT;
+  RMW_CONNEXT_TRACEPOINT(send_request_entry, client);
+  rmw_ret_t ret;
+  if (client_info->shared_requester_) {
+    ret = client_info->shared_requester_->send_request(request, sequence_id);
+  } else {
+    ret = _write_serialized_message(client_info->request_datawriter_, request, write_params);
+    if (ret == RMW_RET_OK) {
+      *sequence_id = _sequence_number_to_int64(write_params.identity.sequence_number);
+    }
+  }
+  if (ret != RMW_RET_OK) {
+    return ret;
+  }
+  RMW_CONNEXT_TRACEPOINT(send_request_exit, client, *sequence_id);
+  reservation.add(*sequence_id);
+  client_info->requests_sent_.fetch_add(1, std::memory_order_relaxed);
+  client_info->request_times_.add(nullptr, *sequence_id);
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+take_response_serialized(
+  const rmw_client_t * client,
+  rmw_request_id_t * request_header,
+  rmw_serialized_message_t * response,
+  bool * taken)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(request_header, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(response, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+  ConnextStaticClientInfo * client_info = _get_serialized_client_info(client);
+  if (!client_info) {
+    return RMW_RET_ERROR;
+  }
+
+  RMW_CONNEXT_TRACEPOINT(take_response_entry, client);
+  DDS::InstanceHandle_t writer_handle = client_info->request_datawriter_->get_instance_handle();
+  InFlightRequests * in_flight = client_info->in_flight_;
+  if (client_info->shared_requester_) {
+    if (!client_info->shared_requester_->take_response(request_header, response, taken)) {
+      return RMW_RET_ERROR;
+    }
+  } else if (!_take_serialized_message(
+      client_info->response_datareader_, writer_handle.keyHash.value, in_flight,
+      request_header, response, taken))
+  {
+    return RMW_RET_ERROR;
+  }
+  if (in_flight && !*taken) {
+    // the client may have been woken up by expired requests, they have been reported
+    in_flight->reset_condition();
+  }
+  std::chrono::nanoseconds round_trip_time;
+  if (*taken &&
+    client_info->request_times_.remove(
+      nullptr, request_header->sequence_number, round_trip_time))
+  {
+    client_info->round_trip_time_.record(round_trip_time);
+  }
+  RMW_CONNEXT_TRACEPOINT(
+    take_response_exit, client, *taken, request_header->writer_guid,
+    request_header->sequence_number);
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+take_request_serialized(
+  const rmw_service_t * service,
+  rmw_request_id_t * request_header,
+  rmw_serialized_message_t * request,
+  bool * taken)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(request_header, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(request, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+  ConnextStaticServiceInfo * service_info = _get_serialized_service_info(service);
+  if (!service_info) {
+    return RMW_RET_ERROR;
+  }
+
+  RMW_CONNEXT_TRACEPOINT(take_request_entry, service);
+  size_t taken_count = 0;
+  if (!_take_serialized_requests(service_info, 1, request_header, request, &taken_count)) {
+    return RMW_RET_ERROR;
+  }
+  *taken = taken_count > 0;
+  RMW_CONNEXT_TRACEPOINT(
+    take_request_exit, service, *taken, request_header->writer_guid,
+    request_header->sequence_number);
+  if (*taken) {
+    _record_taken_request(service_info, *request_header);
+  }
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+send_response_serialized(
+  const rmw_service_t * service,
+  const rmw_request_id_t * request_header,
+  const rmw_serialized_message_t * response)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(request_header, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(response, RMW_RET_INVALID_ARGUMENT);
+  ConnextStaticServiceInfo * service_info = _get_serialized_service_info(service);
+  if (!service_info) {
+    return RMW_RET_ERROR;
+  }
+
+  if (!_write_serialized_response(service, service_info, request_header, response))
+  {
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+take_requests_serialized(
+  const rmw_service_t * service,
+  size_t count,
+  rmw_request_id_t * request_headers,
+  rmw_serialized_message_t * requests,
+  size_t * taken_count)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(request_headers, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(requests, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken_count, RMW_RET_INVALID_ARGUMENT);
+  ConnextStaticServiceInfo * service_info = _get_serialized_service_info(service);
+  if (!service_info) {
+    return RMW_RET_ERROR;
+  }
+
+  RMW_CONNEXT_TRACEPOINT(take_request_entry, service);
+  if (!_take_serialized_requests(service_info, count, request_headers, requests, taken_count)) {
+    return RMW_RET_ERROR;
+  }
+  for (size_t i = 0; i < *taken_count; ++i) {
+    RMW_CONNEXT_TRACEPOINT(
+      take_request_exit, service, true, request_headers[i].writer_guid,
+      request_headers[i].sequence_number);
+    _record_taken_request(service_info, request_headers[i]);
+  }
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+send_responses_serialized(
+  const rmw_service_t * service,
+  size_t count,
+  const rmw_request_id_t * request_headers,
+  const rmw_serialized_message_t * responses)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(request_headers, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(responses, RMW_RET_INVALID_ARGUMENT);
+  ConnextStaticServiceInfo * service_info = _get_serialized_service_info(service);
+  if (!service_info) {
+    return RMW_RET_ERROR;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!_write_serialized_response(service, service_info, &request_headers[i], &responses[i])) {
+      return RMW_RET_ERROR;
+    }
+  }
+  // a batching datawriter would otherwise hold the last responses until the flush delay
+  if (count > 0 && service_info->response_datawriter_->flush() != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to flush data writer");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
+
+}  // namespace rmw_connext_cpp
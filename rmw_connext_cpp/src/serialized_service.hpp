@@ -0,0 +1,172 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef SERIALIZED_SERVICE_HPP_
+#define SERIALIZED_SERVICE_HPP_
+
+#include <cstdint>
+
+#include "rmw/types.h"
+
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+#include "rmw_connext_shared_cpp/types.hpp"
+
+#include "rosidl_typesupport_connext_cpp/service_type_support.h"
+
+struct ConnextStaticServiceInfo;
+
+/// Register the content filter of the replies to the requests of one datawriter.
+/**
+ * The datareaders of serialized requesters read the replies through it.
+ * Services register it with their participant too, so that their reply datawriters filter
+ * the replies for each requester instead of sending them to all.
+ *
+ * \return false if the filter could not be registered, the error is set
+ */
+bool
+_register_reply_filter(DDS::DomainParticipant * participant);
+
+/// Register the request and reply types of a serialized client or service of a node.
+/**
+ * Requests and replies are samples of the serialized data type, registered with the type
+ * names of the typed samples without type code, so that they are exchanged with typed
+ * services and clients alike.
+ *
+ * \return false if a typed client or service of the node uses the types, or they could not
+ *   be registered, the error is set
+ */
+bool
+_register_serialized_service_types(
+  ConnextNodeInfo * node_info,
+  const service_type_support_callbacks_t * callbacks);
+
+/// Check that no serialized client or service of the node uses the types of a typed one.
+/**
+ * \return false if the types are used by serialized clients or services, the error is set
+ */
+bool
+_check_typed_service_types(
+  ConnextNodeInfo * node_info,
+  const service_type_support_callbacks_t * callbacks);
+
+/// Name of the topic read by a datareader, also through a content filtered topic.
+inline const char *
+_get_reader_topic_name(DDS::DataReader * datareader)
+{
+  DDS::TopicDescription * topic_description = datareader->get_topicdescription();
+  DDS::ContentFilteredTopic * filtered_topic =
+    DDS::ContentFilteredTopic::narrow(topic_description);
+  if (filtered_topic) {
+    return filtered_topic->get_related_topic()->get_name();
+  }
+  return topic_description->get_name();
+}
+
+/// Create the entities of a client of serialized requests in place of a Connext Requester.
+/**
+ * The types have to be registered by `_register_serialized_service_types()` before.
+ * The replies are read through the reply filter, on the GUID of the request datawriter.
+ *
+ * \return false if an entity could not be created, the error is set and nothing is leaked
+ */
+bool
+_create_serialized_requester(
+  DDS::DomainParticipant * participant,
+  const service_type_support_callbacks_t * callbacks,
+  const char * request_topic_str,
+  const char * response_topic_str,
+  const DDS::DataReaderQos & datareader_qos,
+  const DDS::DataWriterQos & datawriter_qos,
+  DDS::DataReader ** response_datareader,
+  DDS::DataWriter ** request_datawriter);
+
+/// Create the entities of a service of serialized requests in place of a Connext Replier.
+/**
+ * The types have to be registered by `_register_serialized_service_types()` before.
+ *
+ * \return false if an entity could not be created, the error is set and nothing is leaked
+ */
+bool
+_create_serialized_replier(
+  DDS::DomainParticipant * participant,
+  const service_type_support_callbacks_t * callbacks,
+  const char * request_topic_str,
+  const char * response_topic_str,
+  const DDS::DataReaderQos & datareader_qos,
+  const DDS::DataWriterQos & datawriter_qos,
+  DDS::DataReader ** request_datareader,
+  DDS::DataWriter ** response_datawriter);
+
+/// Create another datareader of the requests of a serialized replier, for a request lane.
+/**
+ * The datareader has the qos of `request_datareader` and a subscriber of its own, in
+ * `partition` unless it is empty.
+ *
+ * \return the datareader, or `NULL` if it could not be created, the error is set
+ */
+DDS::DataReader *
+_create_serialized_lane_datareader(
+  DDS::DomainParticipant * participant,
+  DDS::DataReader * request_datareader,
+  const char * partition);
+
+/// Delete the datareaders of the request lanes of a serialized replier, if any.
+/**
+ * \return false if a datareader could not be deleted, the error is set
+ */
+bool
+_delete_request_lanes(ConnextStaticServiceInfo * service_info);
+
+/// Delete the datareader and datawriter of a serialized requester or replier.
+/**
+ * The reply filtered topic of the datareader of a requester is deleted with it.
+ * The read conditions of the datareader have to be deleted before.
+ *
+ * \return false if an entity could not be deleted, the error is set
+ */
+bool
+_delete_serialized_entities(
+  DDS::DomainParticipant * participant,
+  DDS::DataReader * datareader,
+  DDS::DataWriter * datawriter);
+
+/// Write a serialized request or response.
+/**
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_TIMEOUT` if the datawriter queue stayed full, e.g. because the request queue
+ *   of the service is full, or
+ * \return `RMW_RET_ERROR` if the message could not be written, the error is set
+ */
+rmw_ret_t
+_write_serialized_message(
+  DDS::DataWriter * datawriter,
+  const rmw_serialized_message_t * serialized_message,
+  DDS_WriteParams_t & write_params);
+
+/// Convert the sequence number of a sample identity to the one of a request header.
+inline int64_t
+_sequence_number_to_int64(const DDS_SequenceNumber_t & sequence_number)
+{
+  return (static_cast<int64_t>(sequence_number.high) << 32) | sequence_number.low;
+}
+
+inline DDS_SequenceNumber_t
+_int64_to_sequence_number(int64_t sequence_number)
+{
+  DDS_SequenceNumber_t dds_sequence_number;
+  dds_sequence_number.high = static_cast<DDS_Long>(sequence_number >> 32);
+  dds_sequence_number.low = static_cast<DDS_UnsignedLong>(sequence_number & 0xFFFFFFFF);
+  return dds_sequence_number;
+}
+
+#endif  // SERIALIZED_SERVICE_HPP_
@@ -0,0 +1,411 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "rmw/error_handling.h"
+
+#include "rmw_connext_shared_cpp/environment.hpp"
+#include "rmw_connext_shared_cpp/trigger_guard_condition.hpp"
+
+#include "rmw_connext_cpp/connext_static_client_info.hpp"
+#include "rmw_connext_cpp/identifier.hpp"
+
+#include "in_flight_requests.hpp"
+#include "serialized_data.hpp"
+#include "serialized_service.hpp"
+#include "shared_requester.hpp"
+#include "type_support_common.hpp"
+
+// include patched generated code from the build folder
+#include "connext_static_serialized_dataSupport.h"
+
+// Requests whose replies are still routed to their clients, beyond which the oldest requests
+// are forgotten, since the replies of a service which went away never arrive.
+static const size_t max_routed_requests = 4096;
+
+bool
+SharedRequester::get(
+  ConnextNodeInfo * node_info,
+  const service_type_support_callbacks_t * callbacks,
+  const char * request_topic_str,
+  const char * response_topic_str,
+  const DDS::DataReaderQos & datareader_qos,
+  const DDS::DataWriterQos & datawriter_qos,
+  std::shared_ptr<SharedRequester> & requester)
+{
+  static std::mutex registry_mutex;
+  static std::map<std::string, std::weak_ptr<SharedRequester>> registry;
+
+  requester.reset();
+  std::string topics;
+  if (!get_env_string(RMW_CONNEXT_SHARED_REQUESTER_TOPICS_ENV_VAR, topics)) {
+    return false;
+  }
+  if (!topic_name_matches(topics, request_topic_str)) {
+    return true;
+  }
+
+  // each node has its own participant, the entities can only be shared within it
+  std::string key =
+    std::to_string(reinterpret_cast<uintptr_t>(node_info->participant)) + "/" +
+    request_topic_str + "/" + _create_type_name(callbacks, "Request");
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  requester = registry[key].lock();
+  if (requester) {
+    return true;
+  }
+
+  // the entities are created with the qos of the first client
+  DDS::DataReader * response_datareader = nullptr;
+  DDS::DataWriter * request_datawriter = nullptr;
+  if (!_create_serialized_requester(
+      node_info->participant, callbacks, request_topic_str, response_topic_str,
+      datareader_qos, datawriter_qos, &response_datareader, &request_datawriter))
+  {
+    return false;
+  }
+  requester = std::make_shared<SharedRequester>(
+    node_info, response_datareader, request_datawriter);
+  if (!requester->init()) {
+    requester.reset();
+    return false;
+  }
+  registry[key] = requester;
+  return true;
+}
+
+SharedRequester::SharedRequester(
+  ConnextNodeInfo * node_info,
+  DDS::DataReader * response_datareader,
+  DDS::DataWriter * request_datawriter)
+: node_info_(node_info),
+  response_datareader_(response_datareader),
+  request_datawriter_(request_datawriter),
+  registered_(false),
+  last_registered_sequence_id_((std::numeric_limits<int64_t>::min)()),
+  request_subscription_count_(0),
+  response_publication_count_(0)
+{}
+
+SharedRequester::~SharedRequester()
+{
+  request_datawriter_->set_listener(nullptr, DDS::STATUS_MASK_NONE);
+  response_datareader_->set_listener(nullptr, DDS::STATUS_MASK_NONE);
+  if (registered_) {
+    node_info_->subscriber_listener->remove_information(
+      response_datareader_->get_instance_handle(), EntityType::Subscriber);
+    node_info_->subscriber_listener->trigger_graph_guard_condition();
+    node_info_->publisher_listener->remove_information(
+      request_datawriter_->get_instance_handle(), EntityType::Publisher);
+    node_info_->publisher_listener->trigger_graph_guard_condition();
+  }
+  if (!_delete_serialized_entities(
+      node_info_->participant, response_datareader_, request_datawriter_))
+  {
+    fprintf(
+      stderr, "failed to delete shared requester entities: %s\n", rmw_get_error_string().str);
+    rmw_reset_error();
+  }
+}
+
+DDS::DataReader *
+SharedRequester::get_response_datareader() const
+{
+  return response_datareader_;
+}
+
+DDS::DataWriter *
+SharedRequester::get_request_datawriter() const
+{
+  return request_datawriter_;
+}
+
+void
+SharedRequester::on_publication_matched(
+  DDSDataWriter *,
+  const DDS_PublicationMatchedStatus & status)
+{
+  update(request_subscription_count_, status.current_count);
+}
+
+void
+SharedRequester::on_subscription_matched(
+  DDSDataReader *,
+  const DDS_SubscriptionMatchedStatus & status)
+{
+  update(response_publication_count_, status.current_count);
+}
+
+bool
+SharedRequester::init()
+{
+  if (request_datawriter_->set_listener(
+      this, DDS::PUBLICATION_MATCHED_STATUS) != DDS::RETCODE_OK ||
+    response_datareader_->set_listener(
+      this, DDS::SUBSCRIPTION_MATCHED_STATUS) != DDS::RETCODE_OK)
+  {
+    RMW_SET_ERROR_MSG("failed to set shared requester listener");
+    return false;
+  }
+  // pick up the matches made before the listener was attached
+  DDS::PublicationMatchedStatus publication_matched_status;
+  DDS::SubscriptionMatchedStatus subscription_matched_status;
+  if (request_datawriter_->get_publication_matched_status(
+      publication_matched_status) != DDS::RETCODE_OK ||
+    response_datareader_->get_subscription_matched_status(
+      subscription_matched_status) != DDS::RETCODE_OK)
+  {
+    RMW_SET_ERROR_MSG("failed to get matched status");
+    return false;
+  }
+  update(request_subscription_count_, publication_matched_status.current_count);
+  update(response_publication_count_, subscription_matched_status.current_count);
+
+  node_info_->subscriber_listener->add_information(
+    node_info_->participant->get_instance_handle(),
+    response_datareader_->get_instance_handle(),
+    _get_reader_topic_name(response_datareader_),
+    response_datareader_->get_topicdescription()->get_type_name(),
+    EntityType::Subscriber);
+  node_info_->subscriber_listener->trigger_graph_guard_condition();
+  node_info_->publisher_listener->add_information(
+    node_info_->participant->get_instance_handle(),
+    request_datawriter_->get_instance_handle(),
+    request_datawriter_->get_topic()->get_name(),
+    request_datawriter_->get_topic()->get_type_name(),
+    EntityType::Publisher);
+  node_info_->publisher_listener->trigger_graph_guard_condition();
+  registered_ = true;
+  return true;
+}
+
+void
+SharedRequester::update(DDS::Long & count, DDS::Long current_count)
+{
+  std::lock_guard<std::mutex> lock(match_mutex_);
+  bool was_available = request_subscription_count_ > 0 && response_publication_count_ > 0;
+  count = current_count;
+  for (auto client : clients_) {
+    client->client_info_->request_subscription_count_ = request_subscription_count_;
+    client->client_info_->response_publication_count_ = response_publication_count_;
+  }
+  bool is_available = request_subscription_count_ > 0 && response_publication_count_ > 0;
+  if (was_available == is_available || clients_.empty()) {
+    return;
+  }
+  rmw_ret_t ret = trigger_guard_condition(
+    rti_connext_identifier, node_info_->graph_guard_condition);
+  if (ret != RMW_RET_OK) {
+    fprintf(stderr, "failed to trigger graph guard condition: %s\n", rmw_get_error_string().str);
+  }
+}
+
+bool
+SharedRequester::dispatch()
+{
+  ConnextStaticSerializedDataDataReader * data_reader =
+    ConnextStaticSerializedDataDataReader::narrow(response_datareader_);
+  if (!data_reader) {
+    RMW_SET_ERROR_MSG("failed to narrow data reader");
+    return false;
+  }
+  for (;; ) {
+    ConnextStaticSerializedDataSeq dds_messages;
+    DDS::SampleInfoSeq sample_infos;
+    DDS::ReturnCode_t status = data_reader->take(
+      dds_messages,
+      sample_infos,
+      DDS::LENGTH_UNLIMITED,
+      DDS::ANY_SAMPLE_STATE,
+      DDS::ANY_VIEW_STATE,
+      DDS::ANY_INSTANCE_STATE);
+    if (status == DDS::RETCODE_NO_DATA) {
+      return true;
+    }
+    if (status != DDS::RETCODE_OK) {
+      RMW_SET_ERROR_MSG("take failed");
+      return false;
+    }
+
+    for (DDS::Long i = 0; i < dds_messages.length(); ++i) {
+      const DDS::SampleInfo & sample_info = sample_infos[i];
+      if (!sample_info.valid_data) {
+        continue;
+      }
+      // the reply filter only passes the replies to the requests of the shared datawriter
+      DDS_SampleIdentity_t identity;
+      DDS_SampleInfo_get_related_sample_identity(&sample_info, &identity);
+      int64_t sequence_number = _sequence_number_to_int64(identity.sequence_number);
+      auto request = requests_.find(sequence_number);
+      if (request == requests_.end() && sequence_number <= last_registered_sequence_id_) {
+        // the client is gone or the request was forgotten
+        continue;
+      }
+
+      DDS::OctetSeq & serialized_data = dds_messages[i].serialized_data;
+      const uint8_t * buffer =
+        reinterpret_cast<const uint8_t *>(serialized_data.get_contiguous_buffer());
+      SharedRequesterReply reply;
+      memcpy(
+        reply.request_header.writer_guid, identity.writer_guid.value,
+        sizeof(identity.writer_guid.value));
+      reply.request_header.sequence_number = sequence_number;
+      reply.serialized_data.assign(buffer, buffer + serialized_data.length());
+      if (request == requests_.end()) {
+        // the request is being registered by the client which wrote it
+        unclaimed_replies_.push_back(std::move(reply));
+        continue;
+      }
+      SharedRequesterClient * client = request->second;
+      requests_.erase(request);
+      client->replies_.push_back(std::move(reply));
+      client->condition_.set_trigger_value(DDS::BOOLEAN_TRUE);
+    }
+    data_reader->return_loan(dds_messages, sample_infos);
+  }
+}
+
+SharedRequesterClient::SharedRequesterClient(
+  std::shared_ptr<SharedRequester> requester,
+  ConnextStaticClientInfo * client_info)
+: requester_(std::move(requester)),
+  client_info_(client_info)
+{
+  std::lock_guard<std::mutex> lock(requester_->match_mutex_);
+  requester_->clients_.push_back(this);
+  client_info_->request_subscription_count_ = requester_->request_subscription_count_;
+  client_info_->response_publication_count_ = requester_->response_publication_count_;
+}
+
+SharedRequesterClient::~SharedRequesterClient()
+{
+  {
+    std::lock_guard<std::mutex> lock(requester_->mutex_);
+    auto & requests = requester_->requests_;
+    for (auto it = requests.begin(); it != requests.end(); ) {
+      if (it->second == this) {
+        it = requests.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  std::lock_guard<std::mutex> lock(requester_->match_mutex_);
+  auto & clients = requester_->clients_;
+  clients.erase(std::remove(clients.begin(), clients.end(), this), clients.end());
+}
+
+rmw_ret_t
+SharedRequesterClient::send_request(
+  const rmw_serialized_message_t * request,
+  int64_t * sequence_id)
+{
+  std::lock_guard<std::mutex> write_lock(requester_->write_mutex_);
+  DDS_WriteParams_t write_params = DDS_WRITEPARAMS_DEFAULT;
+  rmw_ret_t ret =
+    _write_serialized_message(requester_->request_datawriter_, request, write_params);
+  if (ret != RMW_RET_OK) {
+    return ret;
+  }
+  *sequence_id = _sequence_number_to_int64(write_params.identity.sequence_number);
+
+  std::lock_guard<std::mutex> lock(requester_->mutex_);
+  auto & requests = requester_->requests_;
+  // forget the requests of this client which expired without a reply
+  InFlightRequests * in_flight = client_info_->in_flight_;
+  if (in_flight) {
+    auto end = requests.upper_bound(in_flight->get_last_expired_sequence_id());
+    for (auto it = requests.begin(); it != end; ) {
+      if (it->second == this) {
+        it = requests.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  if (requests.size() >= max_routed_requests) {
+    requests.erase(requests.begin());
+  }
+  requester_->last_registered_sequence_id_ = *sequence_id;
+
+  // the reply may have been taken by another client while the request was not registered
+  // and the replies to older requests can not be claimed anymore
+  bool replied = false;
+  auto & unclaimed_replies = requester_->unclaimed_replies_;
+  for (auto it = unclaimed_replies.begin(); it != unclaimed_replies.end(); ) {
+    if (it->request_header.sequence_number > *sequence_id) {
+      ++it;
+      continue;
+    }
+    if (it->request_header.sequence_number == *sequence_id) {
+      replies_.push_back(std::move(*it));
+      condition_.set_trigger_value(DDS::BOOLEAN_TRUE);
+      replied = true;
+    }
+    it = unclaimed_replies.erase(it);
+  }
+  if (!replied) {
+    requests[*sequence_id] = this;
+  }
+  return RMW_RET_OK;
+}
+
+bool
+SharedRequesterClient::take_response(
+  rmw_request_id_t * request_header,
+  rmw_serialized_message_t * response,
+  bool * taken)
+{
+  std::lock_guard<std::mutex> lock(requester_->mutex_);
+  if (!requester_->dispatch()) {
+    return false;
+  }
+
+  *taken = false;
+  InFlightRequests * in_flight = client_info_->in_flight_;
+  while (!replies_.empty() && !*taken) {
+    SharedRequesterReply & reply = replies_.front();
+    // replies to expired requests are dropped before they are copied
+    if (!in_flight || in_flight->complete(reply.request_header.sequence_number)) {
+      if (!_copy_to_serialized_message(
+          reply.serialized_data.data(), reply.serialized_data.size(), response))
+      {
+        return false;
+      }
+      *request_header = reply.request_header;
+      *taken = true;
+    }
+    replies_.pop_front();
+  }
+  if (replies_.empty()) {
+    condition_.set_trigger_value(DDS::BOOLEAN_FALSE);
+  }
+  return true;
+}
+
+DDS::GuardCondition *
+SharedRequesterClient::get_condition()
+{
+  return &condition_;
+}
@@ -0,0 +1,173 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SHARED_REQUESTER_HPP_
+#define SHARED_REQUESTER_HPP_
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rmw/types.h"
+
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+#include "rmw_connext_shared_cpp/types.hpp"
+
+#include "rosidl_typesupport_connext_cpp/service_type_support.h"
+
+// Comma separated list of DDS request topic names (e.g. "rq/map/lookupRequest,rq/tf_*")
+// whose serialized clients share one request datawriter and response datareader per node.
+// Typed clients of the topics are not affected, their Connext Requesters own their entities.
+#define RMW_CONNEXT_SHARED_REQUESTER_TOPICS_ENV_VAR "RMW_CONNEXT_SHARED_REQUESTER_TOPICS"
+
+struct ConnextStaticClientInfo;
+class SharedRequesterClient;
+
+/// Reply taken from a shared response datareader.
+struct SharedRequesterReply
+{
+  rmw_request_id_t request_header;
+  std::vector<uint8_t> serialized_data;
+};
+
+/// Request datawriter and response datareader shared by the serialized clients of a node.
+/**
+ * All clients write their requests with the same datawriter, so the replies are routed
+ * to the clients by the sequence numbers of their requests.
+ * The replies are taken from the datareader by whichever client takes a response first
+ * and queued for the clients they belong to, whose reply conditions are triggered.
+ * The entities are registered with the graph of the node and deleted with the last client.
+ */
+class SharedRequester : public DDS::DataWriterListener, public DDS::DataReaderListener
+{
+public:
+  /// Get the requester shared for a service, or nothing if the service is not shared.
+  /**
+   * \return false if the configuration could not be read or the entities could not be
+   *   created, the error is set
+   */
+  static bool
+  get(
+    ConnextNodeInfo * node_info,
+    const service_type_support_callbacks_t * callbacks,
+    const char * request_topic_str,
+    const char * response_topic_str,
+    const DDS::DataReaderQos & datareader_qos,
+    const DDS::DataWriterQos & datawriter_qos,
+    std::shared_ptr<SharedRequester> & requester);
+
+  SharedRequester(
+    ConnextNodeInfo * node_info,
+    DDS::DataReader * response_datareader,
+    DDS::DataWriter * request_datawriter);
+
+  ~SharedRequester();
+
+  DDS::DataReader *
+  get_response_datareader() const;
+
+  DDS::DataWriter *
+  get_request_datawriter() const;
+
+  virtual void on_publication_matched(
+    DDSDataWriter *,
+    const DDS_PublicationMatchedStatus & status);
+
+  virtual void on_subscription_matched(
+    DDSDataReader *,
+    const DDS_SubscriptionMatchedStatus & status);
+
+private:
+  friend class SharedRequesterClient;
+
+  // Attach the listener and register the entities with the graph.
+  bool
+  init();
+
+  void
+  update(DDS::Long & count, DDS::Long current_count);
+
+  // Queue the replies of the datareader for the clients of their requests.
+  bool
+  dispatch();
+
+  ConnextNodeInfo * node_info_;
+  DDS::DataReader * response_datareader_;
+  DDS::DataWriter * request_datawriter_;
+  bool registered_;
+
+  // serializes the writes, so that the requests are registered in the order of their
+  // sequence numbers, without blocking the clients taking replies meanwhile
+  std::mutex write_mutex_;
+
+  // protects the requests in flight and the queued replies
+  std::mutex mutex_;
+  // clients of the requests by sequence number, the oldest are forgotten past a maximum
+  std::map<int64_t, SharedRequesterClient *> requests_;
+  int64_t last_registered_sequence_id_;
+  // replies taken while their request was written but not registered yet
+  std::deque<SharedRequesterReply> unclaimed_replies_;
+
+  // protects the clients and the matches, separately from taking replies, since the
+  // listener is called by Connext with the entities locked
+  std::mutex match_mutex_;
+  std::vector<SharedRequesterClient *> clients_;
+  DDS::Long request_subscription_count_;
+  DDS::Long response_publication_count_;
+};
+
+/// Slot of a client in a shared requester.
+class SharedRequesterClient
+{
+public:
+  SharedRequesterClient(
+    std::shared_ptr<SharedRequester> requester,
+    ConnextStaticClientInfo * client_info);
+
+  ~SharedRequesterClient();
+
+  /// Write a request with the shared datawriter.
+  /**
+   * \return `RMW_RET_OK`, or the result of `_write_serialized_message()` with the error set
+   */
+  rmw_ret_t
+  send_request(const rmw_serialized_message_t * request, int64_t * sequence_id);
+
+  /// Take the next reply to a request of this client.
+  /**
+   * \return false if the replies could not be taken, the error is set
+   */
+  bool
+  take_response(
+    rmw_request_id_t * request_header,
+    rmw_serialized_message_t * response,
+    bool * taken);
+
+  DDS::GuardCondition *
+  get_condition();
+
+private:
+  friend class SharedRequester;
+
+  std::shared_ptr<SharedRequester> requester_;
+  ConnextStaticClientInfo * client_info_;
+  // guarded by the mutex of the requester
+  std::deque<SharedRequesterReply> replies_;
+  DDS::GuardCondition condition_;
+};
+
+#endif  // SHARED_REQUESTER_HPP_
@@ -0,0 +1,169 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rmw/error_handling.h"
+#include "rmw/impl/cpp/macros.hpp"
+
+#include "rmw_connext_cpp/statistics.hpp"
+
+#include "rmw_connext_cpp/connext_static_client_info.hpp"
+#include "rmw_connext_cpp/connext_static_publisher_info.hpp"
+#include "rmw_connext_cpp/connext_static_service_info.hpp"
+#include "rmw_connext_cpp/connext_static_subscriber_info.hpp"
+#include "rmw_connext_cpp/identifier.hpp"
+
+namespace rmw_connext_cpp
+{
+
+rmw_ret_t
+get_publisher_statistics(
+  const rmw_publisher_t * publisher,
+  PublisherStatistics * statistics)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  auto publisher_info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!publisher_info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return RMW_RET_ERROR;
+  }
+  DDS::DataWriter * topic_writer = publisher_info->topic_writer_;
+  if (!topic_writer) {
+    RMW_SET_ERROR_MSG("topic writer handle is null");
+    return RMW_RET_ERROR;
+  }
+
+  DDS::DataWriterProtocolStatus status;
+  if (topic_writer->get_datawriter_protocol_status(status) != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to get datawriter protocol status");
+    return RMW_RET_ERROR;
+  }
+  statistics->messages_sent = static_cast<uint64_t>(status.pushed_sample_count);
+  statistics->bytes_sent = static_cast<uint64_t>(status.pushed_sample_bytes);
+  statistics->messages_resent = static_cast<uint64_t>(status.pulled_sample_count);
+  statistics->bytes_resent = static_cast<uint64_t>(status.pulled_sample_bytes);
+  statistics->messages_filtered = static_cast<uint64_t>(status.filtered_sample_count);
+  publisher_info->serialize_time_.get(statistics->serialize_time);
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+get_subscription_statistics(
+  const rmw_subscription_t * subscription,
+  SubscriptionStatistics * statistics)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    subscription handle,
+    subscription->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  auto subscriber_info = static_cast<ConnextStaticSubscriberInfo *>(subscription->data);
+  if (!subscriber_info) {
+    RMW_SET_ERROR_MSG("subscriber info handle is null");
+    return RMW_RET_ERROR;
+  }
+  DDS::DataReader * topic_reader = subscriber_info->topic_reader_;
+  if (!topic_reader) {
+    RMW_SET_ERROR_MSG("topic reader handle is null");
+    return RMW_RET_ERROR;
+  }
+
+  DDS::DataReaderProtocolStatus status;
+  if (topic_reader->get_datareader_protocol_status(status) != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to get datareader protocol status");
+    return RMW_RET_ERROR;
+  }
+  statistics->messages_received = static_cast<uint64_t>(status.received_sample_count);
+  statistics->bytes_received = static_cast<uint64_t>(status.received_sample_bytes);
+  statistics->messages_duplicate = static_cast<uint64_t>(status.duplicate_sample_count);
+  statistics->messages_lost = subscriber_info->listener_->lost_count();
+  statistics->messages_rejected = subscriber_info->listener_->rejected_count();
+  subscriber_info->deserialize_time_.get(statistics->deserialize_time);
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+get_client_statistics(
+  const rmw_client_t * client,
+  ClientStatistics * statistics)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    client handle,
+    client->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  auto client_info = static_cast<ConnextStaticClientInfo *>(client->data);
+  if (!client_info) {
+    RMW_SET_ERROR_MSG("client info handle is null");
+    return RMW_RET_ERROR;
+  }
+  statistics->requests_sent = client_info->requests_sent_.load(std::memory_order_relaxed);
+  client_info->round_trip_time_.get(statistics->round_trip_time);
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+get_service_statistics(
+  const rmw_service_t * service,
+  ServiceStatistics * statistics)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(service, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    service handle,
+    service->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION)
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  auto service_info = static_cast<ConnextStaticServiceInfo *>(service->data);
+  if (!service_info) {
+    RMW_SET_ERROR_MSG("service info handle is null");
+    return RMW_RET_ERROR;
+  }
+  statistics->requests_taken = service_info->requests_taken_.load(std::memory_order_relaxed);
+  statistics->responses_dropped =
+    service_info->responses_dropped_.load(std::memory_order_relaxed);
+  service_info->response_time_.get(statistics->response_time);
+  return RMW_RET_OK;
+}
+
+uint64_t
+get_time_histogram_percentile(const TimeHistogram & histogram, double percentile)
+{
+  if (!histogram.count) {
+    return 0;
+  }
+  // the rank of the duration at the percentile, counted from 1
+  double rank = percentile / 100.0 * static_cast<double>(histogram.count);
+  uint64_t count = 0;
+  for (size_t i = 0; i < time_histogram_bucket_count - 1; ++i) {
+    count += histogram.buckets[i];
+    if (count > 0 && static_cast<double>(count) >= rank) {
+      // bucket i holds the durations below 2^i us
+      uint64_t upper_bound_ns = (static_cast<uint64_t>(1) << i) * 1000;
+      return upper_bound_ns < histogram.max_ns ? upper_bound_ns : histogram.max_ns;
+    }
+  }
+  return histogram.max_ns;
+}
+
+}  // namespace rmw_connext_cpp
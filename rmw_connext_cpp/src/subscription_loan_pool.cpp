@@ -0,0 +1,92 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <mutex>
+
+#include "subscription_loan_pool.hpp"
+
+SubscriptionLoanPool::SubscriptionLoanPool(
+  ConnextStaticSerializedDataDataReader * data_reader, size_t max_loans)
+: data_reader_(data_reader),
+  loans_(new Loan[max_loans]),
+  max_loans_(max_loans)
+{
+  for (size_t i = 0; i < max_loans_; ++i) {
+    loans_[i].buffer = nullptr;
+    loans_[i].in_use = false;
+  }
+}
+
+SubscriptionLoanPool::~SubscriptionLoanPool()
+{
+  for (size_t i = 0; i < max_loans_; ++i) {
+    if (loans_[i].in_use) {
+      release(&loans_[i]);
+    }
+  }
+}
+
+SubscriptionLoanPool::Loan *
+SubscriptionLoanPool::acquire()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < max_loans_; ++i) {
+    if (!loans_[i].in_use) {
+      loans_[i].in_use = true;
+      return &loans_[i];
+    }
+  }
+  return nullptr;
+}
+
+bool
+SubscriptionLoanPool::release(Loan * loan)
+{
+  bool ret = true;
+  if (loan->data_seq.length() > 0 || loan->info_seq.length() > 0) {
+    ret = data_reader_->return_loan(loan->data_seq, loan->info_seq) == DDS::RETCODE_OK;
+  }
+  loan->intra_process_message.buffer.reset();
+  loan->buffer = nullptr;
+  std::lock_guard<std::mutex> lock(mutex_);
+  loan->in_use = false;
+  return ret;
+}
+
+bool
+SubscriptionLoanPool::release(const uint8_t * buffer)
+{
+  Loan * loan = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < max_loans_; ++i) {
+      if (loans_[i].in_use && loans_[i].buffer && loans_[i].buffer == buffer) {
+        loan = &loans_[i];
+        // claim the loan, so that it cannot be given back twice
+        loan->buffer = nullptr;
+        break;
+      }
+    }
+  }
+  if (!loan) {
+    return false;
+  }
+  return release(loan);
+}
+
+ConnextStaticSerializedDataDataReader *
+SubscriptionLoanPool::get_data_reader() const
+{
+  return data_reader_;
+}
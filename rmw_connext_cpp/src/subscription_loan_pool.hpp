@@ -0,0 +1,71 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SUBSCRIPTION_LOAN_POOL_HPP_
+#define SUBSCRIPTION_LOAN_POOL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+
+#include "intra_process.hpp"
+
+// include patched generated code from the build folder
+#include "connext_static_serialized_dataSupport.h"
+
+/// Bounded set of samples which are loaned to the application after being taken.
+class SubscriptionLoanPool
+{
+public:
+  /// A sample loaned from the datareader, or a message delivered in process.
+  struct Loan
+  {
+    ConnextStaticSerializedDataSeq data_seq;
+    DDS::SampleInfoSeq info_seq;
+    IntraProcessMessage intra_process_message;
+    const uint8_t * buffer;
+    bool in_use;
+  };
+
+  SubscriptionLoanPool(ConnextStaticSerializedDataDataReader * data_reader, size_t max_loans);
+
+  /// Return all outstanding loans to the datareader.
+  ~SubscriptionLoanPool();
+
+  /// Get an unused loan, or `nullptr` if all of them are outstanding.
+  Loan *
+  acquire();
+
+  /// Give a loan back, returning the sample to the datareader.
+  bool
+  release(Loan * loan);
+
+  /// Give the loan of a buffer handed out to the application back.
+  bool
+  release(const uint8_t * buffer);
+
+  ConnextStaticSerializedDataDataReader *
+  get_data_reader() const;
+
+private:
+  std::mutex mutex_;
+  ConnextStaticSerializedDataDataReader * data_reader_;
+  std::unique_ptr<Loan[]> loans_;
+  size_t max_loans_;
+};
+
+#endif  // SUBSCRIPTION_LOAN_POOL_HPP_
@@ -94,4 +94,14 @@ _create_type_name(
     "::" + sep + "::dds_::" + callbacks->message_name + "_";
 }
 
+inline std::string
+_create_type_name(
+  const service_type_support_callbacks_t * callbacks,
+  const std::string & suffix)
+{
+  return
+    std::string(callbacks->package_name) +
+    "::srv::dds_::" + callbacks->service_name + "_" + suffix + "_";
+}
+
 #endif  // TYPE_SUPPORT_COMMON_HPP_
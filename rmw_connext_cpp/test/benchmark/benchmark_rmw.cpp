@@ -0,0 +1,342 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the hot paths of the rmw, run with `rmw_connext_cpp_benchmarks`.
+// The results are printed as JSON unless another --benchmark_format is given, so that they
+// can be compared between versions, e.g. with compare.py of Google Benchmark.
+// BM_publish_rate/0 and BM_publish_rate/1 give the messages per second without and with
+// writer side batching, see RMW_CONNEXT_BATCH_TOPICS.
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rmw/names_and_types.h"
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+
+#include "rmw_connext_shared_cpp/qos.hpp"
+#include "rmw_connext_shared_cpp/types.hpp"
+
+#include "rosidl_typesupport_cpp/message_type_support.hpp"
+
+#include "test_msgs/msg/basic_types.hpp"
+#include "test_msgs/msg/unbounded_sequences.hpp"
+
+#include "../rmw_fixture.hpp"
+
+using test_msgs::msg::UnboundedSequences;
+
+static RmwFixture &
+get_fixture()
+{
+  static RmwFixture fixture("rmw_connext_cpp_benchmarks");
+  return fixture;
+}
+
+// Participant of the subscriptions which have to be reached through the transport.
+static RmwFixture &
+get_subscriber_fixture()
+{
+  static RmwFixture fixture("rmw_connext_cpp_benchmarks_subscriber");
+  return fixture;
+}
+
+// Wait for the publisher to match a subscription, so that the messages are sent.
+static void
+wait_for_match(const rmw_publisher_t * publisher)
+{
+  for (size_t attempt = 0; attempt < 1000; ++attempt) {
+    size_t subscription_count = 0;
+    check_rmw_ret(
+      rmw_publisher_count_matched_subscriptions(publisher, &subscription_count),
+      "rmw_publisher_count_matched_subscriptions");
+    if (subscription_count > 0) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  throw std::runtime_error("publisher did not match the subscription");
+}
+
+static const rosidl_message_type_support_t *
+get_type_support()
+{
+  return rosidl_typesupport_cpp::get_message_type_support_handle<UnboundedSequences>();
+}
+
+static UnboundedSequences
+make_message(size_t payload_size)
+{
+  UnboundedSequences message;
+  message.uint8_values.resize(payload_size, 0x2a);
+  return message;
+}
+
+// Payload sizes from 16 B to 8 MB.
+static void
+payload_sizes(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->RangeMultiplier(8)->Range(16, 8 << 20);
+}
+
+// Publish a message and take it again, waiting for it with a wait set.
+static void
+BM_publish_take(benchmark::State & state)
+{
+  try {
+    RmwFixture & fixture = get_fixture();
+    rmw_qos_profile_t qos = rmw_qos_profile_default;
+    qos.depth = 1;
+    auto publisher = fixture.create_publisher(get_type_support(), "/benchmark/publish_take", qos);
+    auto subscription =
+      fixture.create_subscription(get_type_support(), "/benchmark/publish_take", qos);
+    auto wait_set = fixture.create_wait_set(1);
+
+    UnboundedSequences message = make_message(static_cast<size_t>(state.range(0)));
+    UnboundedSequences taken_message;
+    rmw_time_t timeout = {1, 0};
+    for (auto _ : state) {
+      check_rmw_ret(rmw_publish(publisher.get(), &message, nullptr), "rmw_publish");
+      bool taken = false;
+      while (!taken) {
+        void * subscribers[] = {subscription->data};
+        rmw_subscriptions_t subscriptions = {1, subscribers};
+        check_rmw_ret(
+          rmw_wait(&subscriptions, nullptr, nullptr, nullptr, wait_set.get(), &timeout),
+          "rmw_wait");
+        check_rmw_ret(
+          rmw_take(subscription.get(), &taken_message, &taken, nullptr), "rmw_take");
+      }
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+  } catch (const std::exception & e) {
+    state.SkipWithError(e.what());
+  }
+}
+BENCHMARK(BM_publish_take)->Apply(payload_sizes)->UseRealTime();
+
+// Publish small messages to a subscription of another participant as fast as possible, to a
+// topic without batching (0) and to one batched through RMW_CONNEXT_BATCH_TOPICS (1).
+static void
+BM_publish_rate(benchmark::State & state)
+{
+  try {
+    RmwFixture & fixture = get_fixture();
+    RmwFixture & subscriber_fixture = get_subscriber_fixture();
+    const char * topic_name = state.range(0) ? "/benchmark/batched" : "/benchmark/unbatched";
+    const rosidl_message_type_support_t * type_support =
+      rosidl_typesupport_cpp::get_message_type_support_handle<test_msgs::msg::BasicTypes>();
+    rmw_qos_profile_t qos = rmw_qos_profile_default;
+    qos.depth = 100;
+    auto subscription = subscriber_fixture.create_subscription(type_support, topic_name, qos);
+    auto publisher = fixture.create_publisher(type_support, topic_name, qos);
+    wait_for_match(publisher.get());
+
+    test_msgs::msg::BasicTypes message;
+    for (auto _ : state) {
+      check_rmw_ret(rmw_publish(publisher.get(), &message, nullptr), "rmw_publish");
+    }
+    state.SetItemsProcessed(state.iterations());
+  } catch (const std::exception & e) {
+    state.SkipWithError(e.what());
+  }
+}
+BENCHMARK(BM_publish_rate)->Arg(0)->Arg(1)->UseRealTime();
+
+static void
+BM_serialize(benchmark::State & state)
+{
+  UnboundedSequences message = make_message(static_cast<size_t>(state.range(0)));
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rmw_serialized_message_t serialized_message = rmw_get_zero_initialized_serialized_message();
+  try {
+    check_rmw_ret(
+      rmw_serialized_message_init(&serialized_message, 0, &allocator),
+      "rmw_serialized_message_init");
+    for (auto _ : state) {
+      check_rmw_ret(
+        rmw_serialize(&message, get_type_support(), &serialized_message), "rmw_serialize");
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+  } catch (const std::exception & e) {
+    state.SkipWithError(e.what());
+  }
+  rmw_serialized_message_fini(&serialized_message);
+}
+BENCHMARK(BM_serialize)->Apply(payload_sizes);
+
+static void
+BM_deserialize(benchmark::State & state)
+{
+  UnboundedSequences message = make_message(static_cast<size_t>(state.range(0)));
+  UnboundedSequences deserialized_message;
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rmw_serialized_message_t serialized_message = rmw_get_zero_initialized_serialized_message();
+  try {
+    check_rmw_ret(
+      rmw_serialized_message_init(&serialized_message, 0, &allocator),
+      "rmw_serialized_message_init");
+    check_rmw_ret(
+      rmw_serialize(&message, get_type_support(), &serialized_message), "rmw_serialize");
+    for (auto _ : state) {
+      check_rmw_ret(
+        rmw_deserialize(&serialized_message, get_type_support(), &deserialized_message),
+        "rmw_deserialize");
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+  } catch (const std::exception & e) {
+    state.SkipWithError(e.what());
+  }
+  rmw_serialized_message_fini(&serialized_message);
+}
+BENCHMARK(BM_deserialize)->Apply(payload_sizes);
+
+// Wait for one of N guard conditions, the last one being triggered before each wait, so that
+// the cost of attaching, checking and detaching the conditions is measured.
+static void
+BM_wait(benchmark::State & state)
+{
+  try {
+    RmwFixture & fixture = get_fixture();
+    const size_t count = static_cast<size_t>(state.range(0));
+    std::vector<RmwHandle<rmw_guard_condition_t>> guard_conditions;
+    for (size_t i = 0; i < count; ++i) {
+      guard_conditions.push_back(fixture.create_guard_condition());
+    }
+    auto wait_set = fixture.create_wait_set(count);
+
+    std::vector<void *> conditions(count);
+    rmw_time_t timeout = {1, 0};
+    for (auto _ : state) {
+      for (size_t i = 0; i < count; ++i) {
+        conditions[i] = guard_conditions[i]->data;
+      }
+      rmw_guard_conditions_t waited = {count, conditions.data()};
+      check_rmw_ret(
+        rmw_trigger_guard_condition(guard_conditions.back().get()),
+        "rmw_trigger_guard_condition");
+      check_rmw_ret(
+        rmw_wait(nullptr, &waited, nullptr, nullptr, wait_set.get(), &timeout), "rmw_wait");
+    }
+  } catch (const std::exception & e) {
+    state.SkipWithError(e.what());
+  }
+}
+BENCHMARK(BM_wait)->RangeMultiplier(2)->Range(1, 2000);
+
+// Endpoints of a synthetic graph, as if discovered from other participants, 10 per topic.
+class SyntheticGraph
+{
+public:
+  SyntheticGraph(rmw_node_t * node, size_t endpoint_count)
+  : listener_(static_cast<ConnextNodeInfo *>(node->data)->publisher_listener)
+  {
+    DDS::GUID_t participant_guid;
+    memset(&participant_guid, 0, sizeof(participant_guid));
+    participant_guid.value[0] = 0xbe;
+    for (size_t i = 0; i < endpoint_count; ++i) {
+      DDS::GUID_t guid = participant_guid;
+      memcpy(&guid.value[8], &i, sizeof(i));
+      listener_->add_information(
+        participant_guid, guid, "rt/benchmark/graph_" + std::to_string(i / 10),
+        "test_msgs::msg::dds_::UnboundedSequences_", EntityType::Publisher);
+      guids_.push_back(guid);
+    }
+  }
+
+  ~SyntheticGraph()
+  {
+    for (const auto & guid : guids_) {
+      listener_->remove_information(guid, EntityType::Publisher);
+    }
+  }
+
+private:
+  CustomPublisherListener * listener_;
+  std::vector<DDS::GUID_t> guids_;
+};
+
+static void
+BM_count_publishers(benchmark::State & state)
+{
+  try {
+    RmwFixture & fixture = get_fixture();
+    SyntheticGraph graph(fixture.node(), static_cast<size_t>(state.range(0)));
+    size_t count = 0;
+    for (auto _ : state) {
+      check_rmw_ret(
+        rmw_count_publishers(fixture.node(), "/benchmark/graph_0", &count),
+        "rmw_count_publishers");
+      benchmark::DoNotOptimize(count);
+    }
+  } catch (const std::exception & e) {
+    state.SkipWithError(e.what());
+  }
+}
+BENCHMARK(BM_count_publishers)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void
+BM_get_topic_names_and_types(benchmark::State & state)
+{
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  try {
+    RmwFixture & fixture = get_fixture();
+    SyntheticGraph graph(fixture.node(), static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+      rmw_names_and_types_t topic_names_and_types = rmw_get_zero_initialized_names_and_types();
+      check_rmw_ret(
+        rmw_get_topic_names_and_types(
+          fixture.node(), &allocator, false, &topic_names_and_types),
+        "rmw_get_topic_names_and_types");
+      check_rmw_ret(rmw_names_and_types_fini(&topic_names_and_types), "rmw_names_and_types_fini");
+    }
+  } catch (const std::exception & e) {
+    state.SkipWithError(e.what());
+  }
+}
+BENCHMARK(BM_get_topic_names_and_types)->Arg(100)->Arg(1000)->Arg(10000);
+
+int
+main(int argc, char ** argv)
+{
+  // batch the topic of BM_publish_rate/1 unless batching is configured already
+#ifdef _WIN32
+  if (!getenv(RMW_CONNEXT_BATCH_TOPICS_ENV_VAR)) {
+    _putenv_s(RMW_CONNEXT_BATCH_TOPICS_ENV_VAR, "rt/benchmark/batched");
+  }
+#else
+  setenv(RMW_CONNEXT_BATCH_TOPICS_ENV_VAR, "rt/benchmark/batched", 0);
+#endif
+
+  // the format given on the command line comes later and overrides the default
+  std::vector<char *> args(argv, argv + argc);
+  char json_format[] = "--benchmark_format=json";
+  args.insert(args.begin() + 1, json_format);
+  int args_count = static_cast<int>(args.size());
+  benchmark::Initialize(&args_count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(args_count, args.data())) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,345 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Round trip latency of service calls, run with `rmw_connext_cpp_service_benchmark`.
+// N clients call one server of another node in a loop, for each payload size and number of
+// clients given, e.g.:
+//   rmw_connext_cpp_service_benchmark --clients=1,4,16 --payloads=16,1024,65536 --calls=1000
+// The latencies measured by the clients are reported as p50/p99/p999 next to the estimates
+// of the histograms kept by the rmw, see rmw_connext_cpp/statistics.hpp.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rmw/rmw.h"
+
+#include "rmw_connext_cpp/statistics.hpp"
+
+#include "rosidl_typesupport_cpp/service_type_support.hpp"
+
+#include "test_msgs/srv/basic_types.hpp"
+
+#include "../rmw_fixture.hpp"
+
+using test_msgs::srv::BasicTypes;
+
+static const rosidl_service_type_support_t *
+get_type_support()
+{
+  return rosidl_typesupport_cpp::get_service_type_support_handle<BasicTypes>();
+}
+
+// Parse a comma separated list of numbers given as --<name>=<list>.
+static bool
+parse_list(const char * arg, const char * name, std::vector<size_t> & values)
+{
+  std::string prefix = std::string("--") + name + "=";
+  if (strncmp(arg, prefix.c_str(), prefix.size()) != 0) {
+    return false;
+  }
+  values.clear();
+  const char * list = arg + prefix.size();
+  for (;; ) {
+    // every item has to be a number, strtoull would also take signs, spaces and nothing
+    if (!isdigit(static_cast<unsigned char>(*list))) {
+      throw std::runtime_error(std::string("invalid argument ") + arg);
+    }
+    char * end = nullptr;
+    values.push_back(static_cast<size_t>(strtoull(list, &end, 10)));
+    if (*end == '\0') {
+      return true;
+    }
+    if (*end != ',') {
+      throw std::runtime_error(std::string("invalid argument ") + arg);
+    }
+    list = end + 1;
+  }
+}
+
+// Answer the requests of all clients until stopped.
+static void
+serve(RmwFixture & fixture, rmw_service_t * service, const std::atomic<bool> & stop)
+{
+  RmwHandle<rmw_wait_set_t> wait_set = fixture.create_wait_set(1);
+  BasicTypes::Request request;
+  BasicTypes::Response response;
+  rmw_time_t timeout = {0, 100000000};
+  while (!stop) {
+    void * service_handles[] = {service->data};
+    rmw_services_t services = {1, service_handles};
+    rmw_ret_t ret = rmw_wait(nullptr, nullptr, &services, nullptr, wait_set.get(), &timeout);
+    if (ret == RMW_RET_TIMEOUT) {
+      continue;
+    }
+    check_rmw_ret(ret, "rmw_wait");
+    for (;; ) {
+      rmw_request_id_t request_header;
+      bool taken = false;
+      check_rmw_ret(
+        rmw_take_request(service, &request_header, &request, &taken), "rmw_take_request");
+      if (!taken) {
+        break;
+      }
+      response.string_value.swap(request.string_value);
+      check_rmw_ret(
+        rmw_send_response(service, &request_header, &response), "rmw_send_response");
+    }
+  }
+}
+
+// Call the service in a loop until stopped, recording the latency of each call in nanoseconds.
+static void
+call(
+  RmwFixture & fixture, rmw_client_t * client, size_t payload_size, size_t calls,
+  const std::atomic<bool> & stop, std::vector<int64_t> & latencies)
+{
+  RmwHandle<rmw_wait_set_t> wait_set = fixture.create_wait_set(1);
+  BasicTypes::Request request;
+  request.string_value.assign(payload_size, 'x');
+  BasicTypes::Response response;
+  // the wait is short to notice when stopped, the response may take up to the deadline
+  rmw_time_t timeout = {0, 100000000};
+  const std::chrono::seconds response_deadline(10);
+  for (size_t i = 0; i < calls && !stop; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    int64_t sequence_id = 0;
+    check_rmw_ret(rmw_send_request(client, &request, &sequence_id), "rmw_send_request");
+    bool taken = false;
+    while (!taken) {
+      void * client_handles[] = {client->data};
+      rmw_clients_t clients = {1, client_handles};
+      rmw_ret_t ret = rmw_wait(nullptr, nullptr, nullptr, &clients, wait_set.get(), &timeout);
+      if (stop) {
+        return;
+      }
+      if (ret == RMW_RET_TIMEOUT) {
+        if (std::chrono::steady_clock::now() - start > response_deadline) {
+          throw std::runtime_error("no response within 10 s");
+        }
+        continue;
+      }
+      check_rmw_ret(ret, "rmw_wait");
+      rmw_request_id_t request_header;
+      check_rmw_ret(
+        rmw_take_response(client, &request_header, &response, &taken), "rmw_take_response");
+    }
+    latencies.push_back(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+  }
+}
+
+// Threads of a run, the first error of any of them stops all and is thrown by join().
+class BenchmarkThreads
+{
+public:
+  explicit BenchmarkThreads(std::atomic<bool> & stop)
+  : stop_(stop)
+  {}
+
+  ~BenchmarkThreads()
+  {
+    stop_ = true;
+    for (auto & thread : threads_) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
+  template<typename BodyT>
+  void
+  start(BodyT body)
+  {
+    threads_.emplace_back(
+      [this, body]() {
+        try {
+          body();
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex_);
+          if (!error_) {
+            error_ = std::current_exception();
+          }
+          stop_ = true;
+        }
+      });
+  }
+
+  void
+  join()
+  {
+    for (auto & thread : threads_) {
+      thread.join();
+    }
+    threads_.clear();
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+private:
+  std::atomic<bool> & stop_;
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+  std::vector<std::thread> threads_;
+};
+
+static double
+get_percentile_us(const std::vector<int64_t> & sorted_latencies, double percentile)
+{
+  if (sorted_latencies.empty()) {
+    return 0.0;
+  }
+  size_t index = static_cast<size_t>(percentile / 100.0 * (sorted_latencies.size() - 1));
+  return sorted_latencies[index] / 1000.0;
+}
+
+// Run the clients against a new service, so that the histograms only hold these calls.
+static void
+run(
+  RmwFixture & server_fixture, RmwFixture & client_fixture, size_t client_count,
+  size_t payload_size, size_t calls)
+{
+  std::string service_name =
+    "/benchmark/service_" + std::to_string(client_count) + "_" + std::to_string(payload_size);
+  rmw_qos_profile_t qos = rmw_qos_profile_services_default;
+  RmwHandle<rmw_service_t> service =
+    server_fixture.create_service(get_type_support(), service_name.c_str(), qos);
+  std::vector<RmwHandle<rmw_client_t>> clients;
+  for (size_t i = 0; i < client_count; ++i) {
+    clients.push_back(
+      client_fixture.create_client(get_type_support(), service_name.c_str(), qos));
+  }
+  for (const auto & client : clients) {
+    bool is_available = false;
+    while (!is_available) {
+      check_rmw_ret(
+        rmw_service_server_is_available(client_fixture.node(), client.get(), &is_available),
+        "rmw_service_server_is_available");
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  // the server runs until the last client is done, or any thread failed
+  std::atomic<bool> stop(false);
+  std::atomic<size_t> calling_clients(client_count);
+  std::vector<std::vector<int64_t>> client_latencies(client_count);
+  {
+    BenchmarkThreads threads(stop);
+    threads.start([&]() {serve(server_fixture, service.get(), stop);});
+    for (size_t i = 0; i < client_count; ++i) {
+      client_latencies[i].reserve(calls);
+      threads.start(
+        [&, i]() {
+          call(client_fixture, clients[i].get(), payload_size, calls, stop, client_latencies[i]);
+          if (--calling_clients == 0) {
+            stop = true;
+          }
+        });
+    }
+    threads.join();
+  }
+
+  std::vector<int64_t> latencies;
+  for (const auto & latencies_of_client : client_latencies) {
+    latencies.insert(latencies.end(), latencies_of_client.begin(), latencies_of_client.end());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  // the round trip times of the rmw are merged from the histograms of the clients
+  rmw_connext_cpp::TimeHistogram round_trip_time = {};
+  for (const auto & client : clients) {
+    rmw_connext_cpp::ClientStatistics statistics;
+    check_rmw_ret(
+      rmw_connext_cpp::get_client_statistics(client.get(), &statistics),
+      "get_client_statistics");
+    round_trip_time.count += statistics.round_trip_time.count;
+    round_trip_time.total_ns += statistics.round_trip_time.total_ns;
+    round_trip_time.max_ns = (std::max)(round_trip_time.max_ns, statistics.round_trip_time.max_ns);
+    for (size_t i = 0; i < rmw_connext_cpp::time_histogram_bucket_count; ++i) {
+      round_trip_time.buckets[i] += statistics.round_trip_time.buckets[i];
+    }
+  }
+  rmw_connext_cpp::ServiceStatistics service_statistics;
+  check_rmw_ret(
+    rmw_connext_cpp::get_service_statistics(service.get(), &service_statistics),
+    "get_service_statistics");
+
+  printf(
+    "%7zu %9zu %8zu %10.1f %10.1f %10.1f %12.1f %12.1f %12.1f\n",
+    client_count, payload_size, latencies.size(),
+    get_percentile_us(latencies, 50.0),
+    get_percentile_us(latencies, 99.0),
+    get_percentile_us(latencies, 99.9),
+    rmw_connext_cpp::get_time_histogram_percentile(round_trip_time, 99.0) / 1000.0,
+    rmw_connext_cpp::get_time_histogram_percentile(
+      service_statistics.response_time, 50.0) / 1000.0,
+    rmw_connext_cpp::get_time_histogram_percentile(
+      service_statistics.response_time, 99.0) / 1000.0);
+  fflush(stdout);
+}
+
+int
+main(int argc, char ** argv)
+{
+  try {
+    std::vector<size_t> client_counts = {1, 4, 16};
+    std::vector<size_t> payload_sizes = {16, 1024, 65536};
+    std::vector<size_t> calls = {1000};
+    for (int i = 1; i < argc; ++i) {
+      if (!parse_list(argv[i], "clients", client_counts) &&
+        !parse_list(argv[i], "payloads", payload_sizes) &&
+        !parse_list(argv[i], "calls", calls))
+      {
+        fprintf(
+          stderr, "usage: %s [--clients=1,4,16] [--payloads=16,1024,65536] [--calls=1000]\n",
+          argv[0]);
+        return 1;
+      }
+    }
+    if (calls.size() != 1) {
+      fprintf(stderr, "--calls takes a single number of calls per client\n");
+      return 1;
+    }
+
+    // the server has its own participant, so that the calls go through the transport
+    RmwFixture server_fixture("service_benchmark_server");
+    RmwFixture client_fixture("service_benchmark_clients");
+    printf(
+      "latencies in us, measured by the clients and estimated from the rmw histograms\n"
+      "%7s %9s %8s %10s %10s %10s %12s %12s %12s\n",
+      "clients", "payload", "calls", "p50", "p99", "p999",
+      "rtt p99", "server p50", "server p99");
+    for (size_t payload_size : payload_sizes) {
+      for (size_t client_count : client_counts) {
+        run(server_fixture, client_fixture, client_count, payload_size, calls[0]);
+      }
+    }
+  } catch (const std::exception & e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,179 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_FIXTURE_HPP_
+#define RMW_FIXTURE_HPP_
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "rcutils/allocator.h"
+
+#include "rmw/error_handling.h"
+#include "rmw/init.h"
+#include "rmw/init_options.h"
+#include "rmw/rmw.h"
+#include "rmw/security_options.h"
+
+// Throw the error of a failed rmw call, the tests and benchmarks can not go on without it.
+inline void
+check_rmw_ret(rmw_ret_t ret, const char * what)
+{
+  if (ret != RMW_RET_OK) {
+    std::string error = std::string(what) + " failed: " + rmw_get_error_string().str;
+    rmw_reset_error();
+    throw std::runtime_error(error);
+  }
+}
+
+template<typename T>
+T *
+check_rmw_handle(T * handle, const char * what)
+{
+  if (!handle) {
+    check_rmw_ret(RMW_RET_ERROR, what);
+  }
+  return handle;
+}
+
+/// Entity destroyed when going out of scope, also when a failed call throws.
+template<typename T>
+using RmwHandle = std::unique_ptr<T, std::function<void(T *)>>;
+
+/// Context and node of the tests and benchmarks, which talk to themselves in process.
+class RmwFixture
+{
+public:
+  explicit RmwFixture(const char * node_name)
+  : options_(rmw_get_zero_initialized_init_options()),
+    context_(rmw_get_zero_initialized_context()),
+    node_(nullptr)
+  {
+    check_rmw_ret(
+      rmw_init_options_init(&options_, rcutils_get_default_allocator()), "rmw_init_options_init");
+    // the destructor does not run if the constructor throws
+    try {
+      check_rmw_ret(rmw_init(&options_, &context_), "rmw_init");
+      try {
+        rmw_node_security_options_t security_options = rmw_get_default_node_security_options();
+        node_ = check_rmw_handle(
+          rmw_create_node(&context_, node_name, "/", 0, &security_options), "rmw_create_node");
+      } catch (...) {
+        rmw_shutdown(&context_);
+        rmw_context_fini(&context_);
+        throw;
+      }
+    } catch (...) {
+      rmw_init_options_fini(&options_);
+      throw;
+    }
+  }
+
+  ~RmwFixture()
+  {
+    rmw_destroy_node(node_);
+    rmw_shutdown(&context_);
+    rmw_context_fini(&context_);
+    rmw_init_options_fini(&options_);
+  }
+
+  RmwFixture(const RmwFixture &) = delete;
+  RmwFixture & operator=(const RmwFixture &) = delete;
+
+  rmw_context_t *
+  context()
+  {
+    return &context_;
+  }
+
+  rmw_node_t *
+  node()
+  {
+    return node_;
+  }
+
+  RmwHandle<rmw_publisher_t>
+  create_publisher(
+    const rosidl_message_type_support_t * type_support, const char * topic_name,
+    const rmw_qos_profile_t & qos)
+  {
+    rmw_node_t * node = node_;
+    return RmwHandle<rmw_publisher_t>(
+      check_rmw_handle(
+        rmw_create_publisher(node, type_support, topic_name, &qos), "rmw_create_publisher"),
+      [node](rmw_publisher_t * publisher) {rmw_destroy_publisher(node, publisher);});
+  }
+
+  RmwHandle<rmw_subscription_t>
+  create_subscription(
+    const rosidl_message_type_support_t * type_support, const char * topic_name,
+    const rmw_qos_profile_t & qos)
+  {
+    rmw_node_t * node = node_;
+    return RmwHandle<rmw_subscription_t>(
+      check_rmw_handle(
+        rmw_create_subscription(node, type_support, topic_name, &qos, false),
+        "rmw_create_subscription"),
+      [node](rmw_subscription_t * subscription) {rmw_destroy_subscription(node, subscription);});
+  }
+
+  RmwHandle<rmw_service_t>
+  create_service(
+    const rosidl_service_type_support_t * type_support, const char * service_name,
+    const rmw_qos_profile_t & qos)
+  {
+    rmw_node_t * node = node_;
+    return RmwHandle<rmw_service_t>(
+      check_rmw_handle(
+        rmw_create_service(node, type_support, service_name, &qos), "rmw_create_service"),
+      [node](rmw_service_t * service) {rmw_destroy_service(node, service);});
+  }
+
+  RmwHandle<rmw_client_t>
+  create_client(
+    const rosidl_service_type_support_t * type_support, const char * service_name,
+    const rmw_qos_profile_t & qos)
+  {
+    rmw_node_t * node = node_;
+    return RmwHandle<rmw_client_t>(
+      check_rmw_handle(
+        rmw_create_client(node, type_support, service_name, &qos), "rmw_create_client"),
+      [node](rmw_client_t * client) {rmw_destroy_client(node, client);});
+  }
+
+  RmwHandle<rmw_guard_condition_t>
+  create_guard_condition()
+  {
+    return RmwHandle<rmw_guard_condition_t>(
+      check_rmw_handle(rmw_create_guard_condition(&context_), "rmw_create_guard_condition"),
+      rmw_destroy_guard_condition);
+  }
+
+  RmwHandle<rmw_wait_set_t>
+  create_wait_set(size_t max_conditions)
+  {
+    return RmwHandle<rmw_wait_set_t>(
+      check_rmw_handle(rmw_create_wait_set(&context_, max_conditions), "rmw_create_wait_set"),
+      rmw_destroy_wait_set);
+  }
+
+private:
+  rmw_init_options_t options_;
+  rmw_context_t context_;
+  rmw_node_t * node_;
+};
+
+#endif  // RMW_FIXTURE_HPP_
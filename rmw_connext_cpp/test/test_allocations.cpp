@@ -0,0 +1,284 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Check that publish, take and wait do not allocate once warmed up.
+// The allocations of the calling thread are counted by interposing malloc, rmw_allocate and
+// the rcutils default allocator, which is why the test is only built with glibc and has to
+// export its symbols to the libraries it loads.
+
+#include <dlfcn.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "rcutils/allocator.h"
+
+#include "rmw/allocators.h"
+#include "rmw/rmw.h"
+
+#include "rosidl_typesupport_cpp/message_type_support.hpp"
+
+#include "test_msgs/msg/basic_types.hpp"
+
+#include "rmw_fixture.hpp"
+
+extern "C"
+{
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t count, size_t size);
+void * __libc_realloc(void * pointer, size_t size);
+void __libc_free(void * pointer);
+}
+
+struct AllocationCounts
+{
+  size_t malloc_count;
+  size_t rmw_allocate_count;
+  size_t rcutils_allocate_count;
+};
+
+// only the allocations of the thread calling the measured function are counted, the threads
+// of Connext allocate independently of it
+static thread_local bool counting = false;
+static thread_local AllocationCounts counts = {0, 0, 0};
+
+extern "C"
+{
+void *
+malloc(size_t size)
+{
+  if (counting) {
+    ++counts.malloc_count;
+  }
+  return __libc_malloc(size);
+}
+
+void *
+calloc(size_t count, size_t size)
+{
+  if (counting) {
+    ++counts.malloc_count;
+  }
+  return __libc_calloc(count, size);
+}
+
+void *
+realloc(void * pointer, size_t size)
+{
+  if (counting) {
+    ++counts.malloc_count;
+  }
+  return __libc_realloc(pointer, size);
+}
+
+void
+free(void * pointer)
+{
+  __libc_free(pointer);
+}
+
+void *
+rmw_allocate(size_t size)
+{
+  using rmw_allocate_t = void * (*)(size_t);
+  static rmw_allocate_t next_rmw_allocate =
+    reinterpret_cast<rmw_allocate_t>(dlsym(RTLD_NEXT, "rmw_allocate"));
+  if (counting) {
+    ++counts.rmw_allocate_count;
+  }
+  return next_rmw_allocate(size);
+}
+
+using rcutils_get_default_allocator_t = rcutils_allocator_t (*)();
+
+// The default allocator of rcutils, which the counting one forwards to.
+static const rcutils_allocator_t &
+get_next_default_allocator()
+{
+  static const rcutils_allocator_t allocator =
+    reinterpret_cast<rcutils_get_default_allocator_t>(
+    dlsym(RTLD_NEXT, "rcutils_get_default_allocator"))();
+  return allocator;
+}
+
+static void *
+counting_allocate(size_t size, void * state)
+{
+  if (counting) {
+    ++counts.rcutils_allocate_count;
+  }
+  return get_next_default_allocator().allocate(size, state);
+}
+
+static void *
+counting_reallocate(void * pointer, size_t size, void * state)
+{
+  if (counting) {
+    ++counts.rcutils_allocate_count;
+  }
+  return get_next_default_allocator().reallocate(pointer, size, state);
+}
+
+static void *
+counting_zero_allocate(size_t count, size_t size, void * state)
+{
+  if (counting) {
+    ++counts.rcutils_allocate_count;
+  }
+  return get_next_default_allocator().zero_allocate(count, size, state);
+}
+
+rcutils_allocator_t
+rcutils_get_default_allocator()
+{
+  rcutils_allocator_t allocator = get_next_default_allocator();
+  allocator.allocate = counting_allocate;
+  allocator.reallocate = counting_reallocate;
+  allocator.zero_allocate = counting_zero_allocate;
+  return allocator;
+}
+}  // extern "C"
+
+// Allocations made by the calls of a function, and the ones it is allowed to make.
+struct Budget
+{
+  const char * function;
+  AllocationCounts allowed;
+  AllocationCounts made;
+};
+
+// Count the allocations of a call in a budget.
+template<typename CallT>
+static rmw_ret_t
+count_allocations(Budget & budget, CallT call)
+{
+  counts = {0, 0, 0};
+  counting = true;
+  rmw_ret_t ret = call();
+  counting = false;
+  budget.made.malloc_count += counts.malloc_count;
+  budget.made.rmw_allocate_count += counts.rmw_allocate_count;
+  budget.made.rcutils_allocate_count += counts.rcutils_allocate_count;
+  return ret;
+}
+
+// Record the allocations made by the calls of a function in the test results.
+static void
+record_allocations(const Budget & budget)
+{
+  std::string function = budget.function;
+  ::testing::Test::RecordProperty(function + "_malloc", std::to_string(budget.made.malloc_count));
+  ::testing::Test::RecordProperty(
+    function + "_rmw_allocate", std::to_string(budget.made.rmw_allocate_count));
+  ::testing::Test::RecordProperty(
+    function + "_rcutils_allocate", std::to_string(budget.made.rcutils_allocate_count));
+}
+
+class TestAllocations : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    fixture_.reset(new RmwFixture("test_allocations"));
+    const rosidl_message_type_support_t * type_support =
+      rosidl_typesupport_cpp::get_message_type_support_handle<test_msgs::msg::BasicTypes>();
+    rmw_qos_profile_t qos = rmw_qos_profile_default;
+    qos.depth = 1;
+    publisher_ = fixture_->create_publisher(type_support, "/allocations", qos);
+    subscription_ = fixture_->create_subscription(type_support, "/allocations", qos);
+    wait_set_ = fixture_->create_wait_set(1);
+  }
+
+  void TearDown() override
+  {
+    // the entities are destroyed before the node of the fixture
+    wait_set_.reset();
+    subscription_.reset();
+    publisher_.reset();
+    fixture_.reset();
+  }
+
+  // Publish a message, wait for it and take it, counting the allocations of each call.
+  void
+  round_trip(Budget & publish_budget, Budget & wait_budget, Budget & take_budget)
+  {
+    test_msgs::msg::BasicTypes message;
+    message.int64_value = 42;
+    ASSERT_EQ(
+      RMW_RET_OK, count_allocations(
+        publish_budget, [&]() {return rmw_publish(publisher_.get(), &message, nullptr);}));
+
+    test_msgs::msg::BasicTypes taken_message;
+    bool taken = false;
+    rmw_time_t timeout = {1, 0};
+    for (size_t attempt = 0; attempt < 10 && !taken; ++attempt) {
+      void * subscribers[] = {subscription_->data};
+      rmw_subscriptions_t subscriptions = {1, subscribers};
+      ASSERT_EQ(
+        RMW_RET_OK, count_allocations(
+          wait_budget, [&]() {
+            return rmw_wait(&subscriptions, nullptr, nullptr, nullptr, wait_set_.get(), &timeout);
+          }));
+      ASSERT_EQ(
+        RMW_RET_OK, count_allocations(
+          take_budget, [&]() {
+            return rmw_take(subscription_.get(), &taken_message, &taken, nullptr);
+          }));
+    }
+    ASSERT_TRUE(taken);
+    ASSERT_EQ(42, taken_message.int64_value);
+  }
+
+  std::unique_ptr<RmwFixture> fixture_;
+  RmwHandle<rmw_publisher_t> publisher_;
+  RmwHandle<rmw_subscription_t> subscription_;
+  RmwHandle<rmw_wait_set_t> wait_set_;
+};
+
+TEST_F(TestAllocations, steady_state_publish_take_wait) {
+  const size_t warm_up_iterations = 100;
+  const size_t iterations = 1000;
+
+  Budget warm_up_budgets[3] = {
+    {"rmw_publish", {0, 0, 0}, {0, 0, 0}},
+    {"rmw_wait", {0, 0, 0}, {0, 0, 0}},
+    {"rmw_take", {0, 0, 0}, {0, 0, 0}},
+  };
+  for (size_t i = 0; i < warm_up_iterations; ++i) {
+    SCOPED_TRACE("warm up iteration " + std::to_string(i));
+    ASSERT_NO_FATAL_FAILURE(
+      round_trip(warm_up_budgets[0], warm_up_budgets[1], warm_up_budgets[2]));
+  }
+
+  Budget budgets[3] = {
+    {"rmw_publish", {0, 0, 0}, {0, 0, 0}},
+    {"rmw_wait", {0, 0, 0}, {0, 0, 0}},
+    {"rmw_take", {0, 0, 0}, {0, 0, 0}},
+  };
+  for (size_t i = 0; i < iterations; ++i) {
+    SCOPED_TRACE("iteration " + std::to_string(i));
+    ASSERT_NO_FATAL_FAILURE(round_trip(budgets[0], budgets[1], budgets[2]));
+  }
+
+  for (const Budget & budget : budgets) {
+    record_allocations(budget);
+    EXPECT_LE(budget.made.malloc_count, budget.allowed.malloc_count) << budget.function;
+    EXPECT_LE(budget.made.rmw_allocate_count, budget.allowed.rmw_allocate_count) <<
+      budget.function;
+    EXPECT_LE(budget.made.rcutils_allocate_count, budget.allowed.rcutils_allocate_count) <<
+      budget.function;
+  }
+}
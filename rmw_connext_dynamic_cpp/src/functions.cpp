@@ -74,6 +74,7 @@
 #include "rosidl_typesupport_introspection_c/service_introspection.h"
 #include "rosidl_typesupport_introspection_c/visibility_control.h"
 
+#include "rmw_connext_shared_cpp/message_info.hpp"
 #include "rmw_connext_shared_cpp/shared_functions.hpp"
 #include "rmw_connext_shared_cpp/types.hpp"
 
@@ -154,7 +155,10 @@ struct CustomSubscriberInfo
   DDSDynamicDataReader * dynamic_reader_;
   DDSDataReader * data_reader_;
   DDSReadCondition * read_condition_;
+  // in process delivery is only supported by rmw_connext_cpp
+  DDSGuardCondition * intra_process_condition_;
   DDSSubscriber * dds_subscriber_;
+  // true if samples of the own participant still have to be dropped when taken
   bool ignore_local_publications;
   DDS_TypeCode * type_code_;
   const void * untyped_members_;
@@ -167,6 +171,8 @@ struct ConnextDynamicServiceInfo
   connext::Replier<DDS_DynamicData, DDS_DynamicData> * replier_;
   DDSDataReader * request_datareader_;
   DDSReadCondition * read_condition_;
+  // request lanes are only supported by rmw_connext_cpp
+  std::vector<DDSReadCondition *> lane_conditions_;
   DDS::DynamicDataTypeSupport * request_type_support_;
   DDS::DynamicDataTypeSupport * response_type_support_;
   DDS_TypeCode * response_type_code_;
@@ -181,6 +187,9 @@ struct ConnextDynamicClientInfo
   connext::Requester<DDS_DynamicData, DDS_DynamicData> * requester_;
   DDSDataReader * response_datareader_;
   DDSReadCondition * read_condition_;
+  // request deadlines and shared requesters are only supported by rmw_connext_cpp
+  DDSGuardCondition * expiry_condition_;
+  DDSGuardCondition * reply_condition_;
   DDS::DynamicDataTypeSupport * request_type_support_;
   DDS::DynamicDataTypeSupport * response_type_support_;
   DDS_TypeCode * response_type_code_;
@@ -515,7 +524,11 @@ rmw_create_publisher(
     }
   }
 
-  if (!get_datawriter_qos(participant, *qos_profile, datawriter_qos)) {
+  if (!get_datawriter_qos(participant, *qos_profile, topic_str, datawriter_qos)) {
+    // error string was set within the function
+    goto fail;
+  }
+  if (!check_datawriter_qos_for_type(datawriter_qos, topic_str, type_code)) {
     // error string was set within the function
     goto fail;
   }
@@ -989,6 +1002,7 @@ rmw_create_subscription(
   DDSTopicDescription * topic_description = nullptr;
   DDSDataReader * topic_reader = nullptr;
   DDSReadCondition * read_condition = nullptr;
+  bool check_local_publications = ignore_local_publications;
   DDSDynamicDataReader * dynamic_reader = nullptr;
   DDS_DataReaderQos datareader_qos;
   DDS_DynamicData * dynamic_data = nullptr;
@@ -1067,7 +1081,7 @@ rmw_create_subscription(
     }
   }
 
-  if (!get_datareader_qos(participant, *qos_profile, datareader_qos)) {
+  if (!get_datareader_qos(participant, *qos_profile, topic_name, datareader_qos)) {
     // error string was set within the function
     goto fail;
   }
@@ -1086,6 +1100,14 @@ rmw_create_subscription(
     goto fail;
   }
 
+  // The writers of this participant do not match an ignored subscription at all,
+  // only if that fails the samples are checked when taken.
+  if (ignore_local_publications &&
+    participant->ignore_subscription(topic_reader->get_instance_handle()) == DDS_RETCODE_OK)
+  {
+    check_local_publications = false;
+  }
+
   dynamic_reader = DDSDynamicDataReader::narrow(topic_reader);
   if (!dynamic_reader) {
     RMW_SET_ERROR_MSG("failed to narrow datareader");
@@ -1111,8 +1133,9 @@ rmw_create_subscription(
   custom_subscriber_info->dynamic_reader_ = dynamic_reader;
   custom_subscriber_info->data_reader_ = topic_reader;
   custom_subscriber_info->read_condition_ = read_condition;
+  custom_subscriber_info->intra_process_condition_ = nullptr;
   custom_subscriber_info->dds_subscriber_ = dds_subscriber;
-  custom_subscriber_info->ignore_local_publications = ignore_local_publications;
+  custom_subscriber_info->ignore_local_publications = check_local_publications;
   custom_subscriber_info->type_code_ = type_code;
   custom_subscriber_info->untyped_members_ = type_support->data;
   custom_subscriber_info->dynamic_data = dynamic_data;
@@ -1340,7 +1363,7 @@ rmw_destroy_subscription(rmw_node_t * node, rmw_subscription_t * subscription)
 
 rmw_ret_t
 _take_impl(const rmw_subscription_t * subscription, void * ros_message, bool * taken,
-  DDS_InstanceHandle_t * sending_publication_handle)
+  ConnextMessageInfo * message_info)
 {
   if (!subscription) {
     RMW_SET_ERROR_MSG("subscription handle is null");
@@ -1420,8 +1443,8 @@ _take_impl(const rmw_subscription_t * subscription, void * ros_message, bool * t
       }
     }
   }
-  if (sample_info.valid_data && sending_publication_handle != nullptr) {
-    *sending_publication_handle = sample_info.publication_handle;
+  if (sample_info.valid_data && message_info != nullptr) {
+    set_message_info(rti_connext_dynamic_identifier, sample_info, *message_info);
   }
 
   bool success = true;
@@ -1460,18 +1483,15 @@ rmw_take_with_info(
     RMW_SET_ERROR_MSG("message info is null");
     return RMW_RET_ERROR;
   }
-  DDS_InstanceHandle_t sending_publication_handle;
-  auto ret = _take_impl(subscription, ros_message, taken, &sending_publication_handle);
+  ConnextMessageInfo connext_message_info;
+  auto ret = _take_impl(subscription, ros_message, taken, &connext_message_info);
   if (ret != RMW_RET_OK) {
     // Error string is already set.
     return RMW_RET_ERROR;
   }
-
-  rmw_gid_t * sender_gid = &message_info->publisher_gid;
-  sender_gid->implementation_identifier = rti_connext_dynamic_identifier;
-  memset(sender_gid->data, 0, RMW_GID_STORAGE_SIZE);
-  auto detail = reinterpret_cast<ConnextPublisherGID *>(sender_gid->data);
-  detail->publication_handle = sending_publication_handle;
+  if (*taken) {
+    message_info->publisher_gid = connext_message_info.publisher_gid;
+  }
 
   return RMW_RET_OK;
 }
@@ -1725,11 +1745,18 @@ rmw_create_client(
 
   // create requester
   {
-    if (!get_datareader_qos(participant, *qos_profile, datareader_qos)) {
+    // the requester names its topics after the service, as Connext does by default
+    std::string request_topic_name = std::string(service_name) + "Request";
+    std::string response_topic_name = std::string(service_name) + "Reply";
+    if (!get_datareader_qos(
+        participant, *qos_profile, response_topic_name.c_str(), datareader_qos))
+    {
       // error string was set within the function
       goto fail;
     }
-    if (!get_datawriter_qos(participant, *qos_profile, datawriter_qos)) {
+    if (!get_datawriter_qos(
+        participant, *qos_profile, request_topic_name.c_str(), datawriter_qos))
+    {
       // error string was set within the function
       goto fail;
     }
@@ -1781,6 +1808,8 @@ rmw_create_client(
   client_info->requester_ = requester;
   client_info->response_datareader_ = response_datareader;
   client_info->read_condition_ = read_condition;
+  client_info->expiry_condition_ = nullptr;
+  client_info->reply_condition_ = nullptr;
   client_info->request_type_support_ = request_type_support;
   client_info->response_type_support_ = response_type_support;
   client_info->response_type_code_ = response_type_code;
@@ -2116,11 +2145,18 @@ rmw_create_service(
   buf = nullptr;  // Only free the casted pointer; don't need the buf anymore.
 
   {
-    if (!get_datareader_qos(participant, *qos_profile, datareader_qos)) {
+    // the replier names its topics after the service, as Connext does by default
+    std::string request_topic_name = std::string(service_name) + "Request";
+    std::string response_topic_name = std::string(service_name) + "Reply";
+    if (!get_datareader_qos(
+        participant, *qos_profile, request_topic_name.c_str(), datareader_qos))
+    {
       // error string was set within the function
       goto fail;
     }
-    if (!get_datawriter_qos(participant, *qos_profile, datawriter_qos)) {
+    if (!get_datawriter_qos(
+        participant, *qos_profile, response_topic_name.c_str(), datawriter_qos))
+    {
       // error string was set within the function
       goto fail;
     }
@@ -0,0 +1,45 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_SHARED_CPP__ENVIRONMENT_HPP_
+#define RMW_CONNEXT_SHARED_CPP__ENVIRONMENT_HPP_
+
+#include <cstdint>
+#include <string>
+
+#include "rmw_connext_shared_cpp/visibility_control.h"
+
+/// Get the value of an environment variable, empty if it is not set.
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+get_env_string(const char * name, std::string & value);
+
+/// Get the value of an environment variable as an unsigned integer.
+/**
+ * `value` is left untouched if the variable is not set.
+ * An error is set if the value is not a valid unsigned integer.
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+get_env_uint64(const char * name, uint64_t & value);
+
+/// Check a DDS topic name against a comma separated list of patterns.
+/**
+ * The patterns support the wildcards `*` and `?`, like the `topic_filter` of XML QoS profiles.
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+topic_name_matches(const std::string & patterns, const char * topic_name);
+
+#endif  // RMW_CONNEXT_SHARED_CPP__ENVIRONMENT_HPP_
@@ -0,0 +1,43 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_SHARED_CPP__FLOW_CONTROLLER_HPP_
+#define RMW_CONNEXT_SHARED_CPP__FLOW_CONTROLLER_HPP_
+
+#include "ndds_include.hpp"
+
+#include "rmw_connext_shared_cpp/visibility_control.h"
+
+// Token bucket flow controllers created on each participant, as a comma separated list of
+// "name:bytes_per_period:period_ms", e.g. "images:10485760:100" for 100 MB/s.
+#define RMW_CONNEXT_FLOW_CONTROLLERS_ENV_VAR "RMW_CONNEXT_FLOW_CONTROLLERS"
+// Assignment of flow controllers to DDS topics, as a comma separated list of
+// "topic_pattern=name", e.g. "rt/camera/*=images".
+#define RMW_CONNEXT_FLOW_CONTROLLER_TOPICS_ENV_VAR "RMW_CONNEXT_FLOW_CONTROLLER_TOPICS"
+
+/// Create the flow controllers listed in RMW_CONNEXT_FLOW_CONTROLLERS on the participant.
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+create_flow_controllers(DDS::DomainParticipant * participant);
+
+/// Bind the writer to the flow controller assigned to its topic, if any.
+/**
+ * Flow controllers only apply to asynchronous writers, so assigning one to a writer with
+ * another publish mode, e.g. a batching one, is an error.
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+apply_flow_controller(const char * topic_name, DDS::DataWriterQos & datawriter_qos);
+
+#endif  // RMW_CONNEXT_SHARED_CPP__FLOW_CONTROLLER_HPP_
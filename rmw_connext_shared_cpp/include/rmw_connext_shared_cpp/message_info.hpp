@@ -0,0 +1,55 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_SHARED_CPP__MESSAGE_INFO_HPP_
+#define RMW_CONNEXT_SHARED_CPP__MESSAGE_INFO_HPP_
+
+#include <cstdint>
+
+#include "ndds_include.hpp"
+
+#include "rmw/types.h"
+
+#include "rmw_connext_shared_cpp/visibility_control.h"
+
+/// Information about a taken message beyond rmw_message_info_t.
+struct ConnextMessageInfo
+{
+  rmw_gid_t publisher_gid;
+  // time at which the message was published and received, in nanoseconds since the epoch
+  int64_t source_timestamp;
+  int64_t reception_timestamp;
+  // sequence number given to the message by the publisher, increasing by one per message
+  int64_t publication_sequence_number;
+  // sequence number given by the original publisher, which stays the same when the message
+  // is forwarded, e.g. by a routing or persistence service
+  int64_t original_publication_sequence_number;
+};
+
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+void
+set_publisher_gid(
+  const char * implementation_identifier,
+  const DDS::InstanceHandle_t & publication_handle,
+  rmw_gid_t & publisher_gid);
+
+/// Fill the message info from the sample info of a valid sample.
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+void
+set_message_info(
+  const char * implementation_identifier,
+  const DDS::SampleInfo & sample_info,
+  ConnextMessageInfo & message_info);
+
+#endif  // RMW_CONNEXT_SHARED_CPP__MESSAGE_INFO_HPP_
@@ -19,6 +19,16 @@
 
 #include "rmw_connext_shared_cpp/visibility_control.h"
 
+// Builtin transports used by the participants: "shmem", "udp" or "both".
+// If unset, both are used and local traffic is also sent over the UDP loopback interface
+// to enable cross vendor communication.
+#define RMW_CONNEXT_TRANSPORT_ENV_VAR "RMW_CONNEXT_TRANSPORT"
+// Sizes of the shared memory transport, the Connext defaults are used if unset.
+#define RMW_CONNEXT_SHMEM_RECEIVE_BUFFER_SIZE_ENV_VAR "RMW_CONNEXT_SHMEM_RECEIVE_BUFFER_SIZE"
+#define RMW_CONNEXT_SHMEM_MESSAGE_SIZE_MAX_ENV_VAR "RMW_CONNEXT_SHMEM_MESSAGE_SIZE_MAX"
+#define RMW_CONNEXT_SHMEM_RECEIVED_MESSAGE_COUNT_MAX_ENV_VAR \
+  "RMW_CONNEXT_SHMEM_RECEIVED_MESSAGE_COUNT_MAX"
+
 RMW_CONNEXT_SHARED_CPP_PUBLIC
 rmw_node_t *
 create_node(
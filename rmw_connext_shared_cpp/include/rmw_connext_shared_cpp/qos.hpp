@@ -17,6 +17,7 @@
 
 #include <cassert>
 #include <limits>
+#include <string>
 
 #include "ndds_include.hpp"
 
@@ -25,20 +26,102 @@
 
 #include "rmw_connext_shared_cpp/visibility_control.h"
 
+// Environment variables selecting a QoS profile from the XML files loaded by Connext
+// (e.g. through NDDS_QOS_PROFILES or USER_QOS_PROFILES.xml).
+#define RMW_CONNEXT_QOS_PROFILE_LIBRARY_ENV_VAR "RMW_CONNEXT_QOS_PROFILE_LIBRARY"
+#define RMW_CONNEXT_QOS_PROFILE_ENV_VAR "RMW_CONNEXT_QOS_PROFILE"
+
+// Environment variables enabling writer side batching for the DDS topics matching
+// RMW_CONNEXT_BATCH_TOPICS (a comma separated list of patterns, e.g. "rt/imu*,rt/odom").
+// Batching writers use the synchronous publish mode, in which Connext 5.3 can not fragment
+// samples, so writing a message larger than the message_size_max of the transports fails.
+// Publishers of unbounded types are therefore not created on batched topics, and only topics
+// whose serialized messages fit into a transport message should be batched.
+#define RMW_CONNEXT_BATCH_TOPICS_ENV_VAR "RMW_CONNEXT_BATCH_TOPICS"
+#define RMW_CONNEXT_BATCH_MAX_SAMPLES_ENV_VAR "RMW_CONNEXT_BATCH_MAX_SAMPLES"
+#define RMW_CONNEXT_BATCH_MAX_DATA_BYTES_ENV_VAR "RMW_CONNEXT_BATCH_MAX_DATA_BYTES"
+#define RMW_CONNEXT_BATCH_MAX_FLUSH_DELAY_US_ENV_VAR "RMW_CONNEXT_BATCH_MAX_FLUSH_DELAY_US"
+
+// Environment variables bounding the request queue of the services whose DDS request topics
+// match RMW_CONNEXT_REQUEST_QUEUE_TOPICS (e.g. "rq/plan*Request"). The queue holds
+// RMW_CONNEXT_REQUEST_QUEUE_DEPTH requests, or the depth of the qos profile if it is not set.
+// Clients sending to a full queue fail right away instead of blocking, so both the service
+// and its clients have to be started with the variables set.
+#define RMW_CONNEXT_REQUEST_QUEUE_TOPICS_ENV_VAR "RMW_CONNEXT_REQUEST_QUEUE_TOPICS"
+#define RMW_CONNEXT_REQUEST_QUEUE_DEPTH_ENV_VAR "RMW_CONNEXT_REQUEST_QUEUE_DEPTH"
+
+// Environment variables bounding how long sending a response may block for the services whose
+// DDS reply topics match RMW_CONNEXT_RESPONSE_TIMEOUT_TOPICS (e.g. "rr/*Reply"), 0 by default.
+// Responses which can not be queued in time, e.g. for a slow client, are dropped and counted.
+#define RMW_CONNEXT_RESPONSE_TIMEOUT_TOPICS_ENV_VAR "RMW_CONNEXT_RESPONSE_TIMEOUT_TOPICS"
+#define RMW_CONNEXT_RESPONSE_TIMEOUT_US_ENV_VAR "RMW_CONNEXT_RESPONSE_TIMEOUT_US"
+
+/// Add a property unless the policy, e.g. loaded from an XML profile, already has it.
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+add_property_if_absent(
+  DDS::PropertyQosPolicy & policy,
+  const char * name,
+  const char * value);
+
+/// Get the participant qos, taken from the XML profile selected through the environment if any.
+/**
+ * When a profile is selected, `library_name` and `profile_name` are set to it, otherwise they
+ * are left empty and the factory default participant qos is returned.
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+get_participant_qos(
+  DDS::DomainParticipantFactory * dpf,
+  DDS::DomainParticipantQos & participant_qos,
+  std::string & library_name,
+  std::string & profile_name);
+
+/// Get the datareader qos for the given DDS topic name.
+/**
+ * If the participant has a default QoS profile, the qos is loaded from it, matching the
+ * `topic_filter` attributes of the profile against `topic_name`.
+ * The rmw qos profile is applied on top of it.
+ * Request topics matching RMW_CONNEXT_REQUEST_QUEUE_TOPICS keep all requests up to the
+ * depth of the request queue.
+ */
 RMW_CONNEXT_SHARED_CPP_PUBLIC
 bool
 get_datareader_qos(
   DDS::DomainParticipant * participant,
   const rmw_qos_profile_t & qos_profile,
+  const char * topic_name,
   DDS::DataReaderQos & datareader_qos);
 
+/// Get the datawriter qos for the given DDS topic name.
+/**
+ * See get_datareader_qos() for how the qos is layered.
+ * Batching is enabled if the topic name matches RMW_CONNEXT_BATCH_TOPICS.
+ * Writes to a request topic matching RMW_CONNEXT_REQUEST_QUEUE_TOPICS return
+ * `DDS::RETCODE_TIMEOUT` instead of blocking while the request queue of the service is full,
+ * and writes to a reply topic matching RMW_CONNEXT_RESPONSE_TIMEOUT_TOPICS block for at most
+ * RMW_CONNEXT_RESPONSE_TIMEOUT_US.
+ */
 RMW_CONNEXT_SHARED_CPP_PUBLIC
 bool
 get_datawriter_qos(
   DDS::DomainParticipant * participant,
   const rmw_qos_profile_t & qos_profile,
+  const char * topic_name,
   DDS::DataWriterQos & datawriter_qos);
 
+/// Check that a datawriter with the given qos can write samples of the type.
+/**
+ * Batching datawriters can not fragment samples, so batching is rejected for topics whose
+ * type has no bounded serialized size.
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+check_datawriter_qos_for_type(
+  const DDS::DataWriterQos & datawriter_qos,
+  const char * topic_name,
+  DDS_TypeCode * type_code);
+
 template<typename DDSEntityQos>
 bool
 set_entity_qos_from_profile(
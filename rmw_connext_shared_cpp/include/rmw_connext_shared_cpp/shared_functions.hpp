@@ -18,6 +18,8 @@
 #include "condition_error.hpp"
 #include "count.hpp"
 #include "demangle.hpp"
+#include "environment.hpp"
+#include "flow_controller.hpp"
 #include "guard_condition.hpp"
 #include "init.hpp"
 #include "namespace_prefix.hpp"
@@ -0,0 +1,37 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_SHARED_CPP__TRACE_HPP_
+#define RMW_CONNEXT_SHARED_CPP__TRACE_HPP_
+
+// Tracepoints are only compiled in when building with -DRMW_CONNEXT_ENABLE_TRACING=ON.
+// They are then emitted as USDT probes of the provider "rmw_connext", which cost a nop
+// until a tracer (e.g. bpftrace, SystemTap or LTTng through uprobes) attaches to them.
+// Otherwise the tracepoints and their arguments expand to nothing.
+//
+// Entity GIDs are passed as pointers to the 16 bytes of the Connext GUID, which is the
+// same in every process, so that the events of a sample can be stitched together with its
+// sequence number.
+#ifdef RMW_CONNEXT_TRACING
+#include <sys/sdt.h>
+#define RMW_CONNEXT_TRACEPOINT(...) STAP_PROBEV(rmw_connext, __VA_ARGS__)
+#else
+#define RMW_CONNEXT_TRACEPOINT(...)
+#endif
+
+// Sequence number of a DDS sample as a single integer tracepoint argument.
+#define RMW_CONNEXT_TRACE_SEQUENCE_NUMBER(sn) \
+  ((static_cast<int64_t>((sn).high) << 32) + static_cast<int64_t>((sn).low))
+
+#endif  // RMW_CONNEXT_SHARED_CPP__TRACE_HPP_
@@ -125,12 +125,26 @@ public:
   virtual void on_data_available(DDS::DataReader * reader);
 };
 
+// Serialized data type registered with the participant of a node.
+struct ConnextRegisteredType
+{
+  // whether the samples of the type have an instance key
+  bool keyed;
+  // publishers and subscriptions of the node using the type
+  size_t endpoint_count;
+};
+
 struct ConnextNodeInfo
 {
   DDS::DomainParticipant * participant;
   CustomPublisherListener * publisher_listener;
   CustomSubscriberListener * subscriber_listener;
   rmw_guard_condition_t * graph_guard_condition;
+  rmw_context_t * context;
+  // the serialized data types registered with the participant by type name, since Connext
+  // keeps the first registration of a type name, guarded by keyed_types_mutex
+  std::mutex keyed_types_mutex;
+  std::map<std::string, ConnextRegisteredType> keyed_types;
 };
 
 struct ConnextPublisherGID
@@ -15,6 +15,10 @@
 #ifndef RMW_CONNEXT_SHARED_CPP__WAIT_HPP_
 #define RMW_CONNEXT_SHARED_CPP__WAIT_HPP_
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
 #include "ndds_include.hpp"
 
 #include "rmw/error_handling.h"
@@ -22,10 +26,30 @@
 #include "rmw/types.h"
 
 #include "rmw_connext_shared_cpp/condition_error.hpp"
+#include "rmw_connext_shared_cpp/trace.hpp"
 #include "rmw_connext_shared_cpp/types.hpp"
 #include "rmw_connext_shared_cpp/visibility_control.h"
 
-template<typename SubscriberInfo, typename ServiceInfo, typename ClientInfo>
+/// Default for clients without deadlines of their requests.
+struct NoRequestDeadlines
+{
+  int64_t
+  operator()(rmw_clients_t *) const
+  {
+    return -1;
+  }
+};
+
+/// Wait for any of the entities to become ready.
+/**
+ * `expire_requests` is called with the clients before waiting.
+ * It triggers the expiry conditions of clients whose requests are past their deadline and
+ * returns the nanoseconds until the next deadline, or a negative value if there is none.
+ * The wait does not last beyond that deadline, so that the requests expiring during the
+ * wait make their clients ready.
+ */
+template<typename SubscriberInfo, typename ServiceInfo, typename ClientInfo,
+  typename ExpireRequestsT = NoRequestDeadlines>
 rmw_ret_t
 wait(
   const char * implementation_identifier,
@@ -34,7 +58,8 @@ wait(
   rmw_services_t * services,
   rmw_clients_t * clients,
   rmw_wait_set_t * wait_set,
-  const rmw_time_t * wait_timeout)
+  const rmw_time_t * wait_timeout,
+  ExpireRequestsT expire_requests = ExpireRequestsT())
 {
   // To ensure that we properly clean up the wait set, we declare an
   // object whose destructor will detach what we attached (this was previously
@@ -119,6 +144,13 @@ wait(
     RMW_SET_ERROR_MSG("DDS condition sequence handle is null");
     return RMW_RET_ERROR;
   }
+  DDS::ConditionSeq * attached_conditions =
+    static_cast<DDS::ConditionSeq *>(wait_set_info->attached_conditions);
+  if (!attached_conditions) {
+    RMW_SET_ERROR_MSG("DDS condition sequence handle is null");
+    return RMW_RET_ERROR;
+  }
+  DDS::Long condition_count = 0;
 
   // add a condition for each subscriber
   if (subscriptions) {
@@ -139,6 +171,17 @@ wait(
       if (rmw_status != RMW_RET_OK) {
         return rmw_status;
       }
+      ++condition_count;
+      // messages delivered in process trigger a separate condition
+      DDS::GuardCondition * intra_process_condition = subscriber_info->intra_process_condition_;
+      if (intra_process_condition) {
+        rmw_status = check_attach_condition_error(
+          dds_wait_set->attach_condition(intra_process_condition));
+        if (rmw_status != RMW_RET_OK) {
+          return rmw_status;
+        }
+        ++condition_count;
+      }
     }
   }
 
@@ -156,6 +199,7 @@ wait(
       if (rmw_status != RMW_RET_OK) {
         return rmw_status;
       }
+      ++condition_count;
     }
   }
 
@@ -180,6 +224,16 @@ wait(
       if (rmw_status != RMW_RET_OK) {
         return rmw_status;
       }
+      ++condition_count;
+      // each request lane has a read condition of its own
+      for (DDS::ReadCondition * lane_condition : service_info->lane_conditions_) {
+        rmw_status = check_attach_condition_error(
+          dds_wait_set->attach_condition(lane_condition));
+        if (rmw_status != RMW_RET_OK) {
+          return rmw_status;
+        }
+        ++condition_count;
+      }
     }
   }
 
@@ -210,20 +264,86 @@ wait(
       if (rmw_status != RMW_RET_OK) {
         return rmw_status;
       }
+      ++condition_count;
+      // expired requests trigger a separate condition
+      DDS::GuardCondition * expiry_condition = client_info->expiry_condition_;
+      if (expiry_condition) {
+        rmw_status = check_attach_condition_error(
+          dds_wait_set->attach_condition(expiry_condition));
+        if (rmw_status != RMW_RET_OK) {
+          return rmw_status;
+        }
+        ++condition_count;
+      }
+      // replies dispatched by a shared requester trigger a separate condition
+      DDS::GuardCondition * reply_condition = client_info->reply_condition_;
+      if (reply_condition) {
+        rmw_status = check_attach_condition_error(
+          dds_wait_set->attach_condition(reply_condition));
+        if (rmw_status != RMW_RET_OK) {
+          return rmw_status;
+        }
+        ++condition_count;
+      }
     }
   }
 
-  // invoke wait until one of the conditions triggers
-  DDS::Duration_t timeout;
-  if (!wait_timeout) {
-    timeout.sec = DDS::DURATION_INFINITE_SEC;
-    timeout.nanosec = DDS::DURATION_INFINITE_NSEC;
-  } else {
-    timeout.sec = static_cast<DDS::Long>(wait_timeout->sec);
-    timeout.nanosec = static_cast<DDS::Long>(wait_timeout->nsec);
+  // size the condition sequences for all attached conditions up front, so that waiting
+  // only allocates when the wait set grows and not whenever more conditions trigger
+  if ((active_conditions->maximum() < condition_count &&
+    !active_conditions->maximum(condition_count)) ||
+    (attached_conditions->maximum() < condition_count &&
+    !attached_conditions->maximum(condition_count)))
+  {
+    RMW_SET_ERROR_MSG("failed to resize condition sequences");
+    return RMW_RET_ERROR;
   }
 
-  DDS::ReturnCode_t status = dds_wait_set->wait(*active_conditions, timeout);
+  // invoke wait until one of the conditions triggers
+  DDS::ReturnCode_t status;
+  std::chrono::steady_clock::time_point wait_start;
+  bool wait_started = false;
+  for (;; ) {
+    // wake up at the next deadline of a request, so that the request expires in time
+    int64_t deadline_ns = expire_requests(clients);
+    // a negative timeout waits forever
+    int64_t timeout_ns = -1;
+    if (wait_timeout) {
+      timeout_ns = static_cast<int64_t>(wait_timeout->sec) * 1000000000 +
+        static_cast<int64_t>(wait_timeout->nsec);
+      // only read the clock if the wait may be resumed after a deadline
+      if (deadline_ns >= 0 || wait_started) {
+        auto now = std::chrono::steady_clock::now();
+        if (!wait_started) {
+          wait_start = now;
+          wait_started = true;
+        }
+        timeout_ns -= std::chrono::duration_cast<std::chrono::nanoseconds>(
+          now - wait_start).count();
+        timeout_ns = (std::max)(timeout_ns, static_cast<int64_t>(0));
+      }
+    }
+    bool wait_for_deadline = deadline_ns >= 0 && (timeout_ns < 0 || deadline_ns < timeout_ns);
+    if (wait_for_deadline) {
+      timeout_ns = deadline_ns;
+    }
+
+    DDS::Duration_t timeout;
+    if (timeout_ns < 0) {
+      timeout.sec = DDS::DURATION_INFINITE_SEC;
+      timeout.nanosec = DDS::DURATION_INFINITE_NSEC;
+    } else {
+      timeout.sec = static_cast<DDS::Long>(timeout_ns / 1000000000);
+      timeout.nanosec = static_cast<DDS::UnsignedLong>(timeout_ns % 1000000000);
+    }
+
+    RMW_CONNEXT_TRACEPOINT(wait_entry, wait_set, timeout.sec, timeout.nanosec);
+    status = dds_wait_set->wait(*active_conditions, timeout);
+    RMW_CONNEXT_TRACEPOINT(wait_exit, wait_set, status);
+    if (status != DDS::RETCODE_TIMEOUT || !wait_for_deadline) {
+      break;
+    }
+  }
 
   if (status != DDS::RETCODE_OK && status != DDS::RETCODE_TIMEOUT) {
     RMW_SET_ERROR_MSG("failed to wait on wait set");
@@ -245,10 +365,14 @@ wait(
         return RMW_RET_ERROR;
       }
 
-      // search for subscriber condition in active set
+      DDS::GuardCondition * intra_process_condition = subscriber_info->intra_process_condition_;
+
+      // search for subscriber conditions in active set
       DDS::Long j = 0;
       for (; j < active_conditions->length(); ++j) {
-        if ((*active_conditions)[j] == read_condition) {
+        if ((*active_conditions)[j] == read_condition ||
+          (intra_process_condition && (*active_conditions)[j] == intra_process_condition))
+        {
           break;
         }
       }
@@ -262,6 +386,13 @@ wait(
         RMW_SET_ERROR_MSG("Failed to get detach condition from wait set");
         return RMW_RET_ERROR;
       }
+      if (intra_process_condition) {
+        retcode = dds_wait_set->detach_condition(intra_process_condition);
+        if (retcode != DDS::RETCODE_OK) {
+          RMW_SET_ERROR_MSG("Failed to get detach condition from wait set");
+          return RMW_RET_ERROR;
+        }
+      }
     }
   }
 
@@ -319,7 +450,12 @@ wait(
       // search for service condition in active set
       DDS::Long j = 0;
       for (; j < active_conditions->length(); ++j) {
-        if ((*active_conditions)[j] == read_condition) {
+        DDS::Condition * condition = (*active_conditions)[j];
+        if (condition == read_condition ||
+          std::find(
+            service_info->lane_conditions_.begin(), service_info->lane_conditions_.end(),
+            condition) != service_info->lane_conditions_.end())
+        {
           break;
         }
       }
@@ -333,6 +469,13 @@ wait(
         RMW_SET_ERROR_MSG("Failed to get detach condition from wait set");
         return RMW_RET_ERROR;
       }
+      for (DDS::ReadCondition * lane_condition : service_info->lane_conditions_) {
+        retcode = dds_wait_set->detach_condition(lane_condition);
+        if (retcode != DDS::RETCODE_OK) {
+          RMW_SET_ERROR_MSG("Failed to get detach condition from wait set");
+          return RMW_RET_ERROR;
+        }
+      }
     }
   }
 
@@ -351,10 +494,16 @@ wait(
         return RMW_RET_ERROR;
       }
 
+      DDS::GuardCondition * expiry_condition = client_info->expiry_condition_;
+      DDS::GuardCondition * reply_condition = client_info->reply_condition_;
+
       // search for service condition in active set
       DDS::Long j = 0;
       for (; j < active_conditions->length(); ++j) {
-        if ((*active_conditions)[j] == read_condition) {
+        if ((*active_conditions)[j] == read_condition ||
+          (expiry_condition && (*active_conditions)[j] == expiry_condition) ||
+          (reply_condition && (*active_conditions)[j] == reply_condition))
+        {
           break;
         }
       }
@@ -368,6 +517,20 @@ wait(
         RMW_SET_ERROR_MSG("Failed to get detach condition from wait set");
         return RMW_RET_ERROR;
       }
+      if (expiry_condition) {
+        retcode = dds_wait_set->detach_condition(expiry_condition);
+        if (retcode != DDS::RETCODE_OK) {
+          RMW_SET_ERROR_MSG("Failed to get detach condition from wait set");
+          return RMW_RET_ERROR;
+        }
+      }
+      if (reply_condition) {
+        retcode = dds_wait_set->detach_condition(reply_condition);
+        if (retcode != DDS::RETCODE_OK) {
+          RMW_SET_ERROR_MSG("Failed to get detach condition from wait set");
+          return RMW_RET_ERROR;
+        }
+      }
     }
   }
 
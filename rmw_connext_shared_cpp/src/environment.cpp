@@ -0,0 +1,106 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+
+#include "rcutils/get_env.h"
+
+#include "rmw/error_handling.h"
+
+#include "rmw_connext_shared_cpp/environment.hpp"
+
+bool
+get_env_string(const char * name, std::string & value)
+{
+  const char * env_value = nullptr;
+  const char * error_str = rcutils_get_env(name, &env_value);
+  if (error_str) {
+    RMW_SET_ERROR_MSG(error_str);
+    return false;
+  }
+  value = env_value ? env_value : "";
+  return true;
+}
+
+bool
+get_env_uint64(const char * name, uint64_t & value)
+{
+  std::string env_value;
+  if (!get_env_string(name, env_value)) {
+    return false;
+  }
+  if (env_value.empty()) {
+    return true;
+  }
+  char * end = nullptr;
+  errno = 0;
+  unsigned long long parsed = strtoull(env_value.c_str(), &end, 10);  // NOLINT(runtime/int)
+  if (errno != 0 || *end != '\0' || env_value[0] == '-') {
+    std::string error_msg =
+      std::string("environment variable '") + name + "' is not a valid unsigned integer";
+    RMW_SET_ERROR_MSG(error_msg.c_str());
+    return false;
+  }
+  value = static_cast<uint64_t>(parsed);
+  return true;
+}
+
+static bool
+wildcard_match(const char * pattern, const char * pattern_end, const char * str)
+{
+  const char * star = nullptr;
+  const char * star_str = nullptr;
+  while (*str) {
+    if (pattern != pattern_end && (*pattern == '?' || *pattern == *str)) {
+      ++pattern;
+      ++str;
+    } else if (pattern != pattern_end && *pattern == '*') {
+      star = pattern++;
+      star_str = str;
+    } else if (star) {
+      pattern = star + 1;
+      str = ++star_str;
+    } else {
+      return false;
+    }
+  }
+  while (pattern != pattern_end && *pattern == '*') {
+    ++pattern;
+  }
+  return pattern == pattern_end;
+}
+
+bool
+topic_name_matches(const std::string & patterns, const char * topic_name)
+{
+  if (!topic_name) {
+    return false;
+  }
+  size_t start = 0;
+  while (start <= patterns.size()) {
+    size_t end = patterns.find(',', start);
+    if (end == std::string::npos) {
+      end = patterns.size();
+    }
+    if (end > start &&
+      wildcard_match(patterns.c_str() + start, patterns.c_str() + end, topic_name))
+    {
+      return true;
+    }
+    start = end + 1;
+  }
+  return false;
+}
@@ -0,0 +1,168 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "rmw/error_handling.h"
+
+#include "rmw_connext_shared_cpp/environment.hpp"
+#include "rmw_connext_shared_cpp/flow_controller.hpp"
+#include "rmw_connext_shared_cpp/qos.hpp"
+
+// Each token allows to send this many bytes.
+static const DDS::Long bytes_per_token = 1024;
+
+static std::vector<std::string>
+split(const std::string & str, char delimiter)
+{
+  std::vector<std::string> tokens;
+  size_t start = 0;
+  while (start <= str.size()) {
+    size_t end = str.find(delimiter, start);
+    if (end == std::string::npos) {
+      end = str.size();
+    }
+    tokens.push_back(str.substr(start, end - start));
+    start = end + 1;
+  }
+  return tokens;
+}
+
+static bool
+parse_positive(const std::string & str, uint64_t & value)
+{
+  if (str.empty() || str[0] == '-') {
+    return false;
+  }
+  char * end = nullptr;
+  errno = 0;
+  unsigned long long parsed = strtoull(str.c_str(), &end, 10);  // NOLINT(runtime/int)
+  if (errno != 0 || *end != '\0' || parsed == 0) {
+    return false;
+  }
+  value = static_cast<uint64_t>(parsed);
+  return true;
+}
+
+bool
+create_flow_controllers(DDS::DomainParticipant * participant)
+{
+  std::string flow_controllers;
+  if (!get_env_string(RMW_CONNEXT_FLOW_CONTROLLERS_ENV_VAR, flow_controllers)) {
+    return false;
+  }
+  if (flow_controllers.empty()) {
+    return true;
+  }
+
+  for (const std::string & spec : split(flow_controllers, ',')) {
+    std::vector<std::string> fields = split(spec, ':');
+    uint64_t bytes_per_period = 0;
+    uint64_t period_ms = 0;
+    if (fields.size() != 3 || fields[0].empty() ||
+      !parse_positive(fields[1], bytes_per_period) || !parse_positive(fields[2], period_ms))
+    {
+      std::string error_msg = "invalid flow controller '" + spec + "' in " +
+        RMW_CONNEXT_FLOW_CONTROLLERS_ENV_VAR + ", expected 'name:bytes_per_period:period_ms'";
+      RMW_SET_ERROR_MSG(error_msg.c_str());
+      return false;
+    }
+    uint64_t tokens_per_period = (bytes_per_period + bytes_per_token - 1) / bytes_per_token;
+    if (tokens_per_period > static_cast<uint64_t>((std::numeric_limits<DDS::Long>::max)())) {
+      RMW_SET_ERROR_MSG("flow controller bytes per period exceeds the DDS type");
+      return false;
+    }
+
+    DDS::FlowControllerProperty_t property;
+    if (participant->get_default_flowcontroller_property(property) != DDS::RETCODE_OK) {
+      RMW_SET_ERROR_MSG("failed to get default flow controller property");
+      return false;
+    }
+    property.token_bucket.bytes_per_token = bytes_per_token;
+    property.token_bucket.tokens_added_per_period = static_cast<DDS::Long>(tokens_per_period);
+    // allow a burst of at most one period worth of data
+    property.token_bucket.max_tokens = static_cast<DDS::Long>(tokens_per_period);
+    property.token_bucket.tokens_leaked_per_period = 0;
+    property.token_bucket.period.sec = static_cast<DDS::Long>(period_ms / 1000);
+    property.token_bucket.period.nanosec =
+      static_cast<DDS::UnsignedLong>((period_ms % 1000) * 1000000);
+
+    if (!participant->create_flowcontroller(fields[0].c_str(), property)) {
+      std::string error_msg = "failed to create flow controller '" + fields[0] + "'";
+      RMW_SET_ERROR_MSG(error_msg.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+// Get the name of the flow controller assigned to the topic, left empty if there is none.
+static bool
+get_assigned_flow_controller(const char * topic_name, std::string & flow_controller_name)
+{
+  flow_controller_name.clear();
+  std::string assignments;
+  if (!get_env_string(RMW_CONNEXT_FLOW_CONTROLLER_TOPICS_ENV_VAR, assignments)) {
+    return false;
+  }
+  if (assignments.empty()) {
+    return true;
+  }
+
+  for (const std::string & assignment : split(assignments, ',')) {
+    size_t separator = assignment.rfind('=');
+    if (separator == std::string::npos || separator == 0 ||
+      separator == assignment.size() - 1)
+    {
+      std::string error_msg = "invalid assignment '" + assignment + "' in " +
+        RMW_CONNEXT_FLOW_CONTROLLER_TOPICS_ENV_VAR + ", expected 'topic_pattern=name'";
+      RMW_SET_ERROR_MSG(error_msg.c_str());
+      return false;
+    }
+    if (topic_name_matches(assignment.substr(0, separator), topic_name)) {
+      // the first matching assignment wins
+      flow_controller_name = assignment.substr(separator + 1);
+      return true;
+    }
+  }
+  return true;
+}
+
+bool
+apply_flow_controller(const char * topic_name, DDS::DataWriterQos & datawriter_qos)
+{
+  std::string flow_controller_name;
+  if (!get_assigned_flow_controller(topic_name, flow_controller_name)) {
+    return false;
+  }
+  if (flow_controller_name.empty()) {
+    return true;
+  }
+  if (datawriter_qos.publish_mode.kind != DDS::ASYNCHRONOUS_PUBLISH_MODE_QOS) {
+    // a synchronous writer would silently ignore the flow controller
+    std::string error_msg = "flow controller '" + flow_controller_name + "' is assigned to " +
+      "topic '" + topic_name + "' in " + RMW_CONNEXT_FLOW_CONTROLLER_TOPICS_ENV_VAR +
+      ", but its datawriter publishes synchronously, e.g. because the topic matches " +
+      RMW_CONNEXT_BATCH_TOPICS_ENV_VAR;
+    RMW_SET_ERROR_MSG(error_msg.c_str());
+    return false;
+  }
+  DDS_String_replace(
+    &datawriter_qos.publish_mode.flow_controller_name, flow_controller_name.c_str());
+  return true;
+}
@@ -0,0 +1,58 @@
+// Copyright 2019 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+
+#include "rmw_connext_shared_cpp/message_info.hpp"
+#include "rmw_connext_shared_cpp/types.hpp"
+
+static int64_t
+to_nanoseconds(const DDS::Time_t & time)
+{
+  return static_cast<int64_t>(time.sec) * 1000000000LL + static_cast<int64_t>(time.nanosec);
+}
+
+static int64_t
+to_int64(const DDS::SequenceNumber_t & sequence_number)
+{
+  return (static_cast<int64_t>(sequence_number.high) << 32) +
+         static_cast<int64_t>(sequence_number.low);
+}
+
+void
+set_publisher_gid(
+  const char * implementation_identifier,
+  const DDS::InstanceHandle_t & publication_handle,
+  rmw_gid_t & publisher_gid)
+{
+  publisher_gid.implementation_identifier = implementation_identifier;
+  memset(publisher_gid.data, 0, RMW_GID_STORAGE_SIZE);
+  auto detail = reinterpret_cast<ConnextPublisherGID *>(publisher_gid.data);
+  detail->publication_handle = publication_handle;
+}
+
+void
+set_message_info(
+  const char * implementation_identifier,
+  const DDS::SampleInfo & sample_info,
+  ConnextMessageInfo & message_info)
+{
+  set_publisher_gid(
+    implementation_identifier, sample_info.publication_handle, message_info.publisher_gid);
+  message_info.source_timestamp = to_nanoseconds(sample_info.source_timestamp);
+  message_info.reception_timestamp = to_nanoseconds(sample_info.reception_timestamp);
+  message_info.publication_sequence_number = to_int64(sample_info.publication_sequence_number);
+  message_info.original_publication_sequence_number =
+    to_int64(sample_info.original_publication_virtual_sequence_number);
+}
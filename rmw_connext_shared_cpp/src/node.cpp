@@ -16,15 +16,88 @@
 
 #include "rcutils/filesystem.h"
 
+#include "rmw_connext_shared_cpp/environment.hpp"
+#include "rmw_connext_shared_cpp/flow_controller.hpp"
 #include "rmw_connext_shared_cpp/guard_condition.hpp"
 #include "rmw_connext_shared_cpp/ndds_include.hpp"
 #include "rmw_connext_shared_cpp/node.hpp"
+#include "rmw_connext_shared_cpp/qos.hpp"
 #include "rmw_connext_shared_cpp/types.hpp"
 
 #include "rmw/allocators.h"
 #include "rmw/error_handling.h"
 #include "rmw/impl/cpp/macros.hpp"
 
+static bool
+add_shmem_property_from_env(
+  DDS::DomainParticipantQos & participant_qos,
+  const char * env_var_name,
+  const char * property_name)
+{
+  uint64_t value = 0;
+  if (!get_env_uint64(env_var_name, value)) {
+    return false;
+  }
+  if (value == 0) {
+    return true;
+  }
+  return add_property_if_absent(
+    participant_qos.property, property_name, std::to_string(value).c_str());
+}
+
+// Select the builtin transports according to RMW_CONNEXT_TRANSPORT.
+static bool
+configure_transports(DDS::DomainParticipantQos & participant_qos)
+{
+  std::string transport;
+  if (!get_env_string(RMW_CONNEXT_TRANSPORT_ENV_VAR, transport)) {
+    return false;
+  }
+
+  if (transport.empty()) {
+    // forces local traffic to be sent over loopback,
+    // even if a more efficient transport (such as shared memory) is installed
+    // (in which case traffic will be sent over both transports)
+    return add_property_if_absent(
+      participant_qos.property,
+      "dds.transport.UDPv4.builtin.ignore_loopback_interface",
+      "0");
+  }
+
+  if (transport == "shmem") {
+    participant_qos.transport_builtin.mask = DDS::TRANSPORTBUILTIN_SHMEM;
+  } else if (transport == "udp") {
+    participant_qos.transport_builtin.mask = DDS::TRANSPORTBUILTIN_UDPv4;
+  } else if (transport == "both") {
+    // with shared memory enabled Connext ignores the loopback interface for UDP by default,
+    // so local traffic is sent only once
+    participant_qos.transport_builtin.mask =
+      DDS::TRANSPORTBUILTIN_SHMEM | DDS::TRANSPORTBUILTIN_UDPv4;
+  } else {
+    std::string error_msg = "unknown transport '" + transport + "' in " +
+      RMW_CONNEXT_TRANSPORT_ENV_VAR + ", expected 'shmem', 'udp' or 'both'";
+    RMW_SET_ERROR_MSG(error_msg.c_str());
+    return false;
+  }
+
+  if (participant_qos.transport_builtin.mask & DDS::TRANSPORTBUILTIN_SHMEM) {
+    // note: the message size has to match between participants communicating over shmem
+    if (!add_shmem_property_from_env(
+        participant_qos, RMW_CONNEXT_SHMEM_RECEIVE_BUFFER_SIZE_ENV_VAR,
+        "dds.transport.shmem.builtin.receive_buffer_size") ||
+      !add_shmem_property_from_env(
+        participant_qos, RMW_CONNEXT_SHMEM_MESSAGE_SIZE_MAX_ENV_VAR,
+        "dds.transport.shmem.builtin.message_size_max") ||
+      !add_shmem_property_from_env(
+        participant_qos, RMW_CONNEXT_SHMEM_RECEIVED_MESSAGE_COUNT_MAX_ENV_VAR,
+        "dds.transport.shmem.builtin.received_message_count_max"))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
 rmw_node_t *
 create_node(
   const char * implementation_identifier,
@@ -53,11 +126,13 @@ create_node(
 
   // use loopback interface to enable cross vendor communication
   DDS::DomainParticipantQos participant_qos;
-  DDS::ReturnCode_t status = dpf_->get_default_participant_qos(participant_qos);
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to get default participant qos");
+  std::string qos_library_name;
+  std::string qos_profile_name;
+  if (!get_participant_qos(dpf_, participant_qos, qos_library_name, qos_profile_name)) {
+    // error string was set within the function
     return NULL;
   }
+  DDS::ReturnCode_t status;
   // This String_dup is not matched with a String_free because DDS appears to
   // free this automatically.
   participant_qos.participant_name.name = DDS::String_dup(name);
@@ -90,25 +165,15 @@ create_node(
   // So we set the limit to 1024, to accomodate the complete topic name with namespaces.
   participant_qos.resource_limits.contentfilter_property_max_length = 1024;
 
-  // forces local traffic to be sent over loopback,
-  // even if a more efficient transport (such as shared memory) is installed
-  // (in which case traffic will be sent over both transports)
-  status = DDS::PropertyQosPolicyHelper::add_property(
-    participant_qos.property,
-    "dds.transport.UDPv4.builtin.ignore_loopback_interface",
-    "0",
-    DDS::BOOLEAN_FALSE);
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to add qos property");
+  if (!configure_transports(participant_qos)) {
+    // error string was set within the function
     return NULL;
   }
-  status = DDS::PropertyQosPolicyHelper::add_property(
-    participant_qos.property,
-    "dds.transport.use_510_compatible_locator_kinds",
-    "1",
-    DDS::BOOLEAN_FALSE);
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to add qos property");
+  if (!add_property_if_absent(
+      participant_qos.property,
+      "dds.transport.use_510_compatible_locator_kinds",
+      "1"))
+  {
     return NULL;
   }
 
@@ -270,6 +335,22 @@ create_node(
     goto fail;
   }
 
+  // make the selected profile the base for the qos of all entities of this participant
+  if (!qos_profile_name.empty()) {
+    status = participant->set_default_profile(
+      qos_library_name.c_str(), qos_profile_name.c_str());
+    if (status != DDS::RETCODE_OK) {
+      RMW_SET_ERROR_MSG("failed to set default QoS profile of participant");
+      goto fail;
+    }
+  }
+
+  // the flow controllers have to exist before the writers referring to them are created
+  if (!create_flow_controllers(participant)) {
+    // error string was set within the function
+    goto fail;
+  }
+
   builtin_subscriber = participant->get_builtin_subscriber();
   if (!builtin_subscriber) {
     RMW_SET_ERROR_MSG("builtin subscriber handle is null");
@@ -357,11 +438,16 @@ create_node(
   node_info->publisher_listener = publisher_listener;
   node_info->subscriber_listener = subscriber_listener;
   node_info->graph_guard_condition = graph_guard_condition;
+  node_info->context = context;
 
   node_handle->implementation_identifier = implementation_identifier;
   node_handle->data = node_info;
   return node_handle;
 fail:
+  if (participant) {
+    // flow controllers may have been created already
+    participant->delete_contained_entities();
+  }
   status = dpf_->delete_participant(participant);
   if (status != DDS::RETCODE_OK) {
     std::stringstream ss;
@@ -477,6 +563,8 @@ destroy_node(const char * implementation_identifier, rmw_node_t * node)
     node_info->graph_guard_condition = nullptr;
   }
 
+  RMW_TRY_DESTRUCTOR_FROM_WITHIN_FAILURE(
+    node_info->~ConnextNodeInfo(), ConnextNodeInfo)
   rmw_free(node_info);
   node->data = nullptr;
   rmw_free(const_cast<char *>(node->name));
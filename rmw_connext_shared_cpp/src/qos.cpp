@@ -12,37 +12,215 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <limits>
+#include <string>
+
+#include "rmw_connext_shared_cpp/environment.hpp"
+#include "rmw_connext_shared_cpp/flow_controller.hpp"
 #include "rmw_connext_shared_cpp/qos.hpp"
 
+bool
+add_property_if_absent(
+  DDS::PropertyQosPolicy & policy,
+  const char * name,
+  const char * value)
+{
+  if (DDS::PropertyQosPolicyHelper::lookup_property(policy, name)) {
+    return true;
+  }
+  DDS::ReturnCode_t status = DDS::PropertyQosPolicyHelper::add_property(
+    policy, name, value, DDS::BOOLEAN_FALSE);
+  if (status != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to add qos property");
+    return false;
+  }
+  return true;
+}
+
+// Enable batching if requested for the topic through the environment.
+static bool
+apply_batching_from_env(const char * topic_name, DDS::DataWriterQos & datawriter_qos)
+{
+  std::string batch_topics;
+  if (!get_env_string(RMW_CONNEXT_BATCH_TOPICS_ENV_VAR, batch_topics)) {
+    return false;
+  }
+  if (!topic_name_matches(batch_topics, topic_name)) {
+    return true;
+  }
+
+  // zero keeps the value of the qos profile
+  uint64_t max_samples = 0;
+  uint64_t max_data_bytes = 0;
+  // without a flush delay the last samples of a burst would wait for the next ones
+  uint64_t max_flush_delay_us = 1000;
+  if (!get_env_uint64(RMW_CONNEXT_BATCH_MAX_SAMPLES_ENV_VAR, max_samples) ||
+    !get_env_uint64(RMW_CONNEXT_BATCH_MAX_DATA_BYTES_ENV_VAR, max_data_bytes) ||
+    !get_env_uint64(RMW_CONNEXT_BATCH_MAX_FLUSH_DELAY_US_ENV_VAR, max_flush_delay_us))
+  {
+    return false;
+  }
+  const uint64_t max_long = static_cast<uint64_t>((std::numeric_limits<DDS::Long>::max)());
+  if (max_samples > max_long || max_data_bytes > max_long) {
+    RMW_SET_ERROR_MSG("batch limits exceed the DDS type");
+    return false;
+  }
+  if (max_flush_delay_us / 1000000 > max_long) {
+    RMW_SET_ERROR_MSG("batch flush delay exceeds the DDS type");
+    return false;
+  }
+
+  datawriter_qos.batch.enable = DDS::BOOLEAN_TRUE;
+  if (max_samples) {
+    datawriter_qos.batch.max_samples = static_cast<DDS::Long>(max_samples);
+  }
+  if (max_data_bytes) {
+    datawriter_qos.batch.max_data_bytes = static_cast<DDS::Long>(max_data_bytes);
+  }
+  datawriter_qos.batch.max_flush_delay.sec = static_cast<DDS::Long>(max_flush_delay_us / 1000000);
+  datawriter_qos.batch.max_flush_delay.nanosec =
+    static_cast<DDS::UnsignedLong>((max_flush_delay_us % 1000000) * 1000);
+  return true;
+}
+
+// Bound the request queue if requested for the topic through the environment.
+template<typename DDSEntityQos>
+static bool
+apply_request_queue_from_env(
+  const char * topic_name,
+  DDSEntityQos & entity_qos,
+  bool & applied)
+{
+  applied = false;
+  std::string request_queue_topics;
+  if (!get_env_string(RMW_CONNEXT_REQUEST_QUEUE_TOPICS_ENV_VAR, request_queue_topics)) {
+    return false;
+  }
+  if (!topic_name || !topic_name_matches(request_queue_topics, topic_name)) {
+    return true;
+  }
+
+  uint64_t depth =
+    entity_qos.history.depth > 0 ? static_cast<uint64_t>(entity_qos.history.depth) : 0;
+  if (!get_env_uint64(RMW_CONNEXT_REQUEST_QUEUE_DEPTH_ENV_VAR, depth)) {
+    return false;
+  }
+  if (depth == 0 || depth > static_cast<uint64_t>((std::numeric_limits<DDS::Long>::max)())) {
+    RMW_SET_ERROR_MSG("request queue depth must be positive and fit the DDS type");
+    return false;
+  }
+
+  // requests beyond the depth are rejected by the datareader and stay unacknowledged in the
+  // datawriter, until they fill it as well
+  DDS::Long max_samples = static_cast<DDS::Long>(depth);
+  entity_qos.reliability.kind = DDS::RELIABLE_RELIABILITY_QOS;
+  entity_qos.history.kind = DDS::KEEP_ALL_HISTORY_QOS;
+  entity_qos.history.depth = max_samples;
+  entity_qos.resource_limits.max_samples = max_samples;
+  entity_qos.resource_limits.max_samples_per_instance = max_samples;
+  entity_qos.resource_limits.initial_samples =
+    (std::min)(entity_qos.resource_limits.initial_samples, max_samples);
+  applied = true;
+  return true;
+}
+
+// Bound the blocking time of responses if requested for the topic through the environment.
+static bool
+apply_response_timeout_from_env(const char * topic_name, DDS::DataWriterQos & datawriter_qos)
+{
+  std::string response_timeout_topics;
+  if (!get_env_string(RMW_CONNEXT_RESPONSE_TIMEOUT_TOPICS_ENV_VAR, response_timeout_topics)) {
+    return false;
+  }
+  if (!topic_name || !topic_name_matches(response_timeout_topics, topic_name)) {
+    return true;
+  }
+
+  uint64_t timeout_us = 0;
+  if (!get_env_uint64(RMW_CONNEXT_RESPONSE_TIMEOUT_US_ENV_VAR, timeout_us)) {
+    return false;
+  }
+  if (timeout_us / 1000000 > static_cast<uint64_t>((std::numeric_limits<DDS::Long>::max)())) {
+    RMW_SET_ERROR_MSG("response timeout exceeds the DDS type");
+    return false;
+  }
+  datawriter_qos.reliability.max_blocking_time.sec = static_cast<DDS::Long>(timeout_us / 1000000);
+  datawriter_qos.reliability.max_blocking_time.nanosec =
+    static_cast<DDS::UnsignedLong>((timeout_us % 1000000) * 1000);
+  return true;
+}
+
+bool
+get_participant_qos(
+  DDS::DomainParticipantFactory * dpf,
+  DDS::DomainParticipantQos & participant_qos,
+  std::string & library_name,
+  std::string & profile_name)
+{
+  if (!get_env_string(RMW_CONNEXT_QOS_PROFILE_LIBRARY_ENV_VAR, library_name) ||
+    !get_env_string(RMW_CONNEXT_QOS_PROFILE_ENV_VAR, profile_name))
+  {
+    return false;
+  }
+
+  if (library_name.empty() && profile_name.empty()) {
+    DDS::ReturnCode_t status = dpf->get_default_participant_qos(participant_qos);
+    if (status != DDS::RETCODE_OK) {
+      RMW_SET_ERROR_MSG("failed to get default participant qos");
+      return false;
+    }
+    return true;
+  }
+  if (library_name.empty() || profile_name.empty()) {
+    RMW_SET_ERROR_MSG(
+      "both " RMW_CONNEXT_QOS_PROFILE_LIBRARY_ENV_VAR " and " RMW_CONNEXT_QOS_PROFILE_ENV_VAR
+      " must be set to select a QoS profile");
+    return false;
+  }
+
+  DDS::ReturnCode_t status = dpf->get_participant_qos_from_profile(
+    participant_qos, library_name.c_str(), profile_name.c_str());
+  if (status != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to get participant qos from the selected QoS profile");
+    return false;
+  }
+  return true;
+}
+
 bool
 get_datareader_qos(
   DDS::DomainParticipant * participant,
   const rmw_qos_profile_t & qos_profile,
+  const char * topic_name,
   DDS::DataReaderQos & datareader_qos)
 {
-  DDS::ReturnCode_t status = participant->get_default_datareader_qos(datareader_qos);
+  DDS::ReturnCode_t status;
+  const char * profile_name = participant->get_default_profile();
+  if (profile_name && topic_name) {
+    status = participant->get_datareader_qos_from_profile_w_topic_name(
+      datareader_qos, participant->get_default_profile_library(), profile_name, topic_name);
+  } else {
+    status = participant->get_default_datareader_qos(datareader_qos);
+  }
   if (status != DDS::RETCODE_OK) {
     RMW_SET_ERROR_MSG("failed to get default datareader qos");
     return false;
   }
 
-  status = DDS::PropertyQosPolicyHelper::add_property(
-    datareader_qos.property,
-    "dds.data_reader.history.memory_manager.fast_pool.pool_buffer_max_size",
-    "4096",
-    DDS::BOOLEAN_FALSE);
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to add qos property");
+  if (!add_property_if_absent(
+      datareader_qos.property,
+      "dds.data_reader.history.memory_manager.fast_pool.pool_buffer_max_size",
+      "4096"))
+  {
     return false;
   }
 
-  status = DDS::PropertyQosPolicyHelper::add_property(
-    datareader_qos.property,
-    "reader_resource_limits.dynamically_allocate_fragmented_samples",
-    "1",
-    DDS::BOOLEAN_FALSE);
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to add qos property");
+  if (!add_property_if_absent(
+      datareader_qos.property,
+      "reader_resource_limits.dynamically_allocate_fragmented_samples",
+      "1"))
+  {
     return false;
   }
 
@@ -50,6 +228,11 @@ get_datareader_qos(
     return false;
   }
 
+  bool request_queue;
+  if (!apply_request_queue_from_env(topic_name, datareader_qos, request_queue)) {
+    return false;
+  }
+
   return true;
 }
 
@@ -57,21 +240,27 @@ bool
 get_datawriter_qos(
   DDS::DomainParticipant * participant,
   const rmw_qos_profile_t & qos_profile,
+  const char * topic_name,
   DDS::DataWriterQos & datawriter_qos)
 {
-  DDS::ReturnCode_t status = participant->get_default_datawriter_qos(datawriter_qos);
+  DDS::ReturnCode_t status;
+  const char * profile_name = participant->get_default_profile();
+  if (profile_name && topic_name) {
+    status = participant->get_datawriter_qos_from_profile_w_topic_name(
+      datawriter_qos, participant->get_default_profile_library(), profile_name, topic_name);
+  } else {
+    status = participant->get_default_datawriter_qos(datawriter_qos);
+  }
   if (status != DDS::RETCODE_OK) {
     RMW_SET_ERROR_MSG("failed to get default datawriter qos");
     return false;
   }
 
-  status = DDS::PropertyQosPolicyHelper::add_property(
-    datawriter_qos.property,
-    "dds.data_writer.history.memory_manager.fast_pool.pool_buffer_max_size",
-    "4096",
-    DDS::BOOLEAN_FALSE);
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to add qos property");
+  if (!add_property_if_absent(
+      datawriter_qos.property,
+      "dds.data_writer.history.memory_manager.fast_pool.pool_buffer_max_size",
+      "4096"))
+  {
     return false;
   }
 
@@ -79,9 +268,101 @@ get_datawriter_qos(
     return false;
   }
 
-  // TODO(wjwwood): conditionally use the async publish mode using a heuristic:
-  //  https://github.com/ros2/rmw_connext/issues/190
-  datawriter_qos.publish_mode.kind = DDS::ASYNCHRONOUS_PUBLISH_MODE_QOS;
+  bool request_queue;
+  if (!apply_request_queue_from_env(topic_name, datawriter_qos, request_queue)) {
+    return false;
+  }
+  if (request_queue) {
+    // fail fast when the queue is full, the client can shed the load
+    datawriter_qos.reliability.max_blocking_time.sec = 0;
+    datawriter_qos.reliability.max_blocking_time.nanosec = 0;
+  }
+  if (!apply_response_timeout_from_env(topic_name, datawriter_qos)) {
+    return false;
+  }
+
+  if (!apply_batching_from_env(topic_name, datawriter_qos)) {
+    return false;
+  }
+
+  if (datawriter_qos.batch.enable) {
+    // Connext does not batch samples written by an asynchronous writer,
+    // the flush delay bounds the latency instead; samples larger than a transport message
+    // can not be fragmented by a synchronous writer, see RMW_CONNEXT_BATCH_TOPICS
+    datawriter_qos.publish_mode.kind = DDS::SYNCHRONOUS_PUBLISH_MODE_QOS;
+  } else {
+    // TODO(wjwwood): conditionally use the async publish mode using a heuristic:
+    //  https://github.com/ros2/rmw_connext/issues/190
+    datawriter_qos.publish_mode.kind = DDS::ASYNCHRONOUS_PUBLISH_MODE_QOS;
+  }
+
+  if (!apply_flow_controller(topic_name, datawriter_qos)) {
+    return false;
+  }
 
   return true;
 }
+
+// Whether the serialized size of samples of the type has an upper bound.
+static bool
+is_type_code_bounded(DDS_TypeCode * type_code)
+{
+  DDS_ExceptionCode_t ex = DDS_NO_EXCEPTION_CODE;
+  DDS_TCKind kind = type_code->kind(ex);
+  if (ex != DDS_NO_EXCEPTION_CODE) {
+    return false;
+  }
+  switch (kind) {
+    case DDS_TK_STRING:
+    case DDS_TK_WSTRING:
+      {
+        // unbounded strings are created with the largest bound
+        DDS_UnsignedLong length = type_code->length(ex);
+        return ex == DDS_NO_EXCEPTION_CODE && length != 0 && length < RTI_INT32_MAX;
+      }
+    case DDS_TK_SEQUENCE:
+      {
+        DDS_UnsignedLong length = type_code->length(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE || length == 0 || length >= RTI_INT32_MAX) {
+          return false;
+        }
+      }
+      return is_type_code_bounded(type_code->content_type(ex));
+    case DDS_TK_ARRAY:
+    case DDS_TK_ALIAS:
+      return is_type_code_bounded(type_code->content_type(ex));
+    case DDS_TK_STRUCT:
+    case DDS_TK_VALUE:
+      {
+        DDS_UnsignedLong member_count = type_code->member_count(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE) {
+          return false;
+        }
+        for (DDS_UnsignedLong i = 0; i < member_count; ++i) {
+          DDS_TypeCode * member_type = type_code->member_type(i, ex);
+          if (ex != DDS_NO_EXCEPTION_CODE || !is_type_code_bounded(member_type)) {
+            return false;
+          }
+        }
+      }
+      return true;
+    default:
+      return true;
+  }
+}
+
+bool
+check_datawriter_qos_for_type(
+  const DDS::DataWriterQos & datawriter_qos,
+  const char * topic_name,
+  DDS_TypeCode * type_code)
+{
+  if (datawriter_qos.batch.enable && !is_type_code_bounded(type_code)) {
+    std::string error_msg = std::string("topic '") + topic_name + "' matches " +
+      RMW_CONNEXT_BATCH_TOPICS_ENV_VAR + " but its type is unbounded, batching datawriters " +
+      "can not fragment its samples";
+    RMW_SET_ERROR_MSG(error_msg.c_str());
+    return false;
+  }
+  return true;
+}